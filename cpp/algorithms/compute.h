@@ -1,8 +1,146 @@
+//
+// compute.h
+//
+// Every algorithm in this directory defines a static prepare(), compute(), pass_independent,
+// endpoint_local and passes, and registers them with REGISTER_ALGORITHM(name) at the bottom of
+// its file. The program
+// links all algorithms and picks one by name at runtime (see main.cpp).
+//
+// Only prepare() and a whole pass are called through a pointer. Each registered pass is the
+// scheduler's run_pass() instantiated with the algorithm's own compute(), so compute() is still
+// bound at compile time and inlined into the loop over the endpoints.
+//
+
 #ifndef _COMPUTE_H
 #define _COMPUTE_H
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+#include "../checkpoint.h"
+#include "../components.h"
+#include "../executor.h"
+#include "../instance.h"
+#include "../scheduler.h"
+#include "../scorer.h"
 #include "../youtube.h"
 
-void compute(Endpoint *, size_t);
+/**
+ * What prepare() is given to stop in time: in anytime mode (see main.cpp), the end of the
+ * algorithm's share of the budget, and the checkpoint to offer solutions to meanwhile. Algorithms
+ * that do their work in prepare() ask is_over() between steps and stop once it returns true,
+ * leaving a valid solution behind.
+ */
+class Deadline {
+  private:
+    Scorer *scorer;
+    Checkpoint *checkpoint;
+    bool bounded;
+    std::chrono::steady_clock::time_point until;
+
+  public:
+    /**
+     * Constructor for a deadline that never passes, with nowhere to offer solutions.
+     */
+    Deadline(void) : scorer(NULL), checkpoint(NULL), bounded(false) {
+    }
+
+    /**
+     * Constructor.
+     * @arg scorer Scorer following the instance, for the score of offered solutions.
+     * @arg checkpoint Checkpoint to offer solutions to, or NULL.
+     * @arg bounded false if there is no end.
+     * @arg until The end, if bounded.
+     */
+    Deadline(Scorer *scorer, Checkpoint *checkpoint, bool bounded,
+             std::chrono::steady_clock::time_point until)
+        : scorer(scorer), checkpoint(checkpoint), bounded(bounded), until(until) {
+    }
+
+    /**
+     * Offers the videos stored in the caches to the checkpoint once one is due, and once the time
+     * is up. Call only between steps that leave the caches as a solution worth keeping.
+     * @arg instance The instance being solved.
+     * @return true if the time is up.
+     */
+    bool is_over(Instance *instance) {
+      bool over = bounded && std::chrono::steady_clock::now() >= until;
+      if (checkpoint && (over || checkpoint->is_due()))
+        checkpoint->offer(instance, scorer->get_score());
+      return over;
+    }
+};
+
+struct Algorithm {
+  const char *name;
+
+  // true if compute() does the same regardless of the pass number; see scheduler.h
+  bool pass_independent;
+  // true if compute() touches nothing but its endpoint and the endpoint's caches, so that endpoints
+  // sharing no cache can run in any order (see executor.h); algorithms that keep state of their
+  // own across endpoints run one endpoint at a time, in order, and not by component
+  bool endpoint_local;
+  // amount of passes the algorithm needs unless told otherwise; 0 means until nothing changes,
+  // which only pass independent algorithms can do
+  size_t passes;
+
+  // work done once before the passes; it may spread over the threads of the executor, which
+  // deterministic runs expect to give the serial result, and stops once the deadline passes
+  void (*prepare)(Instance *, Executor *, Deadline *);
+
+  // runs one pass of compute() over the endpoints that need a visit
+  void (*run_pass)(Scheduler *, size_t);
+
+  // runs all passes of compute() over one component at a time
+  void (*run_components)(Executor *, Components *, size_t);
+};
+
+template <void (*F)(Endpoint *, size_t)>
+void run_pass_of(Scheduler *scheduler, size_t pass) {
+  scheduler->run_pass<F>(pass);
+}
+
+template <void (*F)(Endpoint *, size_t)>
+void run_components_of(Executor *executor, Components *components, size_t passes) {
+  executor->run_components<F>(components, passes);
+}
+
+/**
+ * @return All registered algorithms, sorted by name.
+ */
+inline std::vector<const Algorithm *> &get_algorithms(void) {
+  static std::vector<const Algorithm *> algorithms;
+  return algorithms;
+}
+
+/**
+ * @arg name Name of an algorithm, as its file is named without .cpp.
+ * @return The algorithm, or NULL if none is registered under this name.
+ */
+inline const Algorithm *find_algorithm(const char *name) {
+  std::vector<const Algorithm *> &algorithms = get_algorithms();
+  for (size_t i = 0; i < algorithms.size(); i++)
+    if (strcmp(algorithms[i]->name, name) == 0)
+      return algorithms[i];
+  return NULL;
+}
+
+// adds an algorithm to the registry while the program starts
+struct Registration {
+  Registration(const Algorithm *algorithm) {
+    std::vector<const Algorithm *> &algorithms = get_algorithms();
+    algorithms.push_back(algorithm);
+    std::sort(algorithms.begin(), algorithms.end(), [](const Algorithm *a, const Algorithm *b) {
+      return strcmp(a->name, b->name) < 0;
+    });
+  }
+};
+
+#define REGISTER_ALGORITHM(NAME) \
+  static const Algorithm algorithm = {#NAME, pass_independent, endpoint_local, passes, prepare, \
+                                      run_pass_of<compute>, run_components_of<compute>}; \
+  static Registration registration(&algorithm)
 
-#endif // _COMPUTE_H
\ No newline at end of file
+#endif // _COMPUTE_H
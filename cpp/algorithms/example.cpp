@@ -14,19 +14,45 @@
  * changes made by one Endpoint during one pass to a Cache will carry over to all subsequent passes
  * and Endpoints.
  *
- * To create a new solution, copy this file and rename it.
+ * Before the first pass, the prepare() function below is called once with the whole Instance. Use
+ * it to set up state that is shared by all endpoints, for instance a GainEngine (see gain.h) that
+ * knows how much latency each video would save in each cache. Work that takes long should ask
+ * deadline->is_over() now and then, and stop once it returns true, and can spread over the
+ * threads of the executor with executor->parallel_for() (see compute.h).
+ *
+ * To create a new solution, copy this file and rename it, and change the name registered at the
+ * bottom to that of your file. The program links every algorithm in this directory (this one only
+ * when asked for) and picks one by name when it runs.
  *
  * Compile your solution with: make runner a=example
- *   with `example` being the name of your source file, without .cpp
+ *   with `example` being the name of your source file, without .cpp; it becomes the default
  *
- * Run your solution with ./run infile [passes] > outfile 
+ * Run your solution with ./run [-a example] infile outfile [passes]
  *
  **************************************************************************************************/
 
 #include "compute.h"
 
-void compute(Endpoint *e, size_t pass) {
+// set to true if compute() ignores the pass number; the program then only revisits endpoints
+// that can change, and runs until nothing changes if no amount of passes is given
+static const bool pass_independent = false;
+
+// set to true if compute() touches nothing but its endpoint and the endpoint's caches; the
+// program then runs endpoints that share no cache side by side, and lets -c split the instance
+// (printing every endpoint in order, as below, does not qualify)
+static const bool endpoint_local = false;
+
+// amount of passes to run if none is given; 0 runs until nothing changes, if pass_independent
+static const size_t passes = 1;
+
+static void prepare(Instance *instance, Executor *executor, Deadline *deadline) {
+  return;
+}
+
+static void compute(Endpoint *e, size_t pass) {
   if (pass == 0)
     e->print();
   return;
 }
+
+REGISTER_ALGORITHM(example);
@@ -3,6 +3,7 @@
 //   requires  ~20 passes for me_at_the_zoo.in
 //   requires ~250 passes for kittens.in
 //   requires ~550 passes for videos_worth_sharing.in
+//   stops by itself when no amount of passes is given
 //
 // A very simple compute function. Each endpoint gets to place one video of their choice in one
 // cache of their choice. The choice is always "greedy" -- they always choose to place their highest
@@ -12,27 +13,31 @@
 
 #include "compute.h"
 
-void compute(Endpoint *e, size_t pass) {
-  // get caches
-  Cache **caches;
-  size_t caches_count = e->get_connected_caches(&caches);
-  
-  // get requests
-  Request **requests;
-  size_t requests_count = e->get_stored_requests(&requests);
+// compute() ignores the pass number, so passes only need to revisit endpoints that can change
+static const bool pass_independent = true;
+
+// compute() touches nothing but its endpoint and the endpoint's caches
+static const bool endpoint_local = true;
+
+// runs until nothing changes
+static const size_t passes = 0;
+
+static void prepare(Instance *instance, Executor *executor, Deadline *deadline) {
+  return;
+}
+
+static void compute(Endpoint *e, size_t pass) {
+  Span<Cache *const> caches = e->get_caches();
+  Request *top = e->get_top_request();
   
   // push one video (the highest scoring one) to one cache  
-  if (requests_count > 0) {
+  if (top != NULL) {
     size_t c = 0;
-    while (c < caches_count)
-      if (caches[c++]->push_video(e, requests[0]))
+    while (c < caches.size())
+      if (caches[c++]->push_video(e, top))
         break;
   }
-  
-  // cleanup
-  if (caches_count > 0)
-    delete[] caches;
-  if (requests_count > 0)
-    delete[] requests;
   return;
-}
\ No newline at end of file
+}
+
+REGISTER_ALGORITHM(greedy);
@@ -0,0 +1,103 @@
+//
+// heap.cpp
+//   requires 1 pass
+//
+// A global greedy compute function. Instead of letting each endpoint place its own videos, all
+// (video, cache) pairs compete in one priority queue, ordered by the latency they would save per
+// MB of cache space (see gain.h). The best pair is placed, which lowers the gains of pairs for the
+// same video in other caches nearby. Rather than updating the queue for every lowered gain, a
+// popped pair is re-evaluated first: if its gain has dropped it is pushed back with its current
+// value, otherwise it is still the best pair and is placed. Gains never increase, so this places
+// exactly the pairs an eager greedy would, and it is done once the queue is empty, or once the
+// deadline passes.
+//
+// All of the work happens in prepare(); the per-endpoint passes have nothing left to do.
+//
+
+#include <chrono>
+#include <queue>
+#include <stdio.h>
+#include <vector>
+
+#include "compute.h"
+#include "../gain.h"
+
+// pairs popped between two looks at the deadline
+static const size_t DEADLINE_INTERVAL = 256;
+
+// compute() ignores the pass number, so passes only need to revisit endpoints that can change
+static const bool pass_independent = true;
+
+// compute() touches nothing but its endpoint and the endpoint's caches
+static const bool endpoint_local = true;
+
+// runs until nothing changes
+static const size_t passes = 0;
+
+// a candidate placement, keyed by its gain per MB at the time it was last evaluated
+struct Entry {
+  double key;
+  uint32_t video, cache;
+
+  bool operator<(const Entry &other) const {
+    return key < other.key;
+  }
+};
+
+static void prepare(Instance *instance, Executor *executor, Deadline *deadline) {
+  using namespace std;
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  GainEngine engine(instance);
+  Span<const size_t> remaining = instance->get_remaining_spaces();
+
+  // queue every pair that saves anything
+  vector<Entry> entries;
+  for (size_t c = 0; c < instance->get_caches_amount(); c++) {
+    Span<const Candidate> candidates = engine.get_candidates(c);
+    for (size_t i = 0; i < candidates.size(); i++)
+      if (candidates[i].gain > 0) {
+        Entry entry = {candidates[i].gain / (double) instance->get_video_size(candidates[i].video),
+                       candidates[i].video, (uint32_t) c};
+        entries.push_back(entry);
+      }
+  }
+  priority_queue<Entry> heap(less<Entry>(), entries);
+  entries.clear();
+
+  size_t evaluated = 0, placed = 0;
+  bool out_of_time = false;
+  while (!heap.empty()) {
+    if (evaluated % DEADLINE_INTERVAL == 0 && (out_of_time = deadline->is_over(instance)))
+      break;
+    Entry top = heap.top();
+    heap.pop();
+    evaluated++;
+
+    // space only ever shrinks, and gains only ever drop; either way the pair can be forgotten
+    size_t size = instance->get_video_size(top.video);
+    uint64_t gain = engine.get_gain(top.video, top.cache);
+    if (size > remaining[top.cache] || gain == 0)
+      continue;
+
+    // re-queue stale pairs with their current gain
+    double key = gain / (double) size;
+    if (key < top.key) {
+      top.key = key;
+      heap.push(top);
+      continue;
+    }
+
+    instance->place_video(top.cache, top.video);
+    placed++;
+  }
+
+  double time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  fprintf(stderr, "Heap:      %lu candidates evaluated in %.3f s (%.0f per second), %lu placed%s\n",
+          evaluated, time, evaluated / time, placed, out_of_time ? ", out of time" : "");
+}
+
+static void compute(Endpoint *e, size_t pass) {
+  return;
+}
+
+REGISTER_ALGORITHM(heap);
@@ -0,0 +1,206 @@
+//
+// knapsack.cpp
+//   requires 1 pass
+//
+// A cache-by-cache compute function. Pushing videos fills a cache first come, first served, so a
+// large video that arrives early can take the room of several smaller ones that would have saved
+// more together. Instead, each cache in turn is filled optimally (see knapsack.h), given what the
+// other caches store: a video the cache stores is worth what removing it would cost, any other
+// video what adding it would save (see gain.h). Only the videos that differ from the best filling
+// are removed or placed. This never lowers the score, since the old contents are one of the
+// fillings considered. Sweeps over all caches repeat until no cache finds a better filling,
+// which makes it block coordinate ascent with a cache as the block. The best filling of a cache
+// only depends on the caches that share an endpoint with it, so a cache is only filled again once
+// one of those has changed. For the same reason, caches that share no endpoint are filled in
+// parallel on the threads given with -t, with the same result as one after another; on instances
+// where all caches share an endpoint, such as trending_today, they still go one at a time. Once
+// the deadline passes, the ascent stops between two caches, or two sets of parallel ones.
+//
+// All of the work happens in prepare(); the per-endpoint passes have nothing left to do. Starting
+// from a solution (-s) continues the ascent from there.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <vector>
+
+#include "compute.h"
+#include "../gain.h"
+#include "../idmap.h"
+#include "../knapsack.h"
+
+// compute() ignores the pass number, so passes only need to revisit endpoints that can change
+static const bool pass_independent = true;
+
+// compute() touches nothing but its endpoint and the endpoint's caches
+static const bool endpoint_local = true;
+
+// runs until nothing changes
+static const size_t passes = 0;
+
+// sweeps stop here even if caches still improve
+static const size_t MAX_SWEEPS = 100;
+
+// a cache to fill: the videos worth storing in it, and the best filling found for them
+struct Fill {
+  size_t cache;
+  std::vector<uint32_t> videos, sizes, chosen;
+  std::vector<uint64_t> gains;
+  uint64_t old_gain, gain;
+};
+
+/**
+ * Finds the best filling of a cache, given what the other caches store, without changing any.
+ * @arg instance The instance.
+ * @arg engine Gains of the videos.
+ * @arg knapsack Solver to use, which no other thread may use meanwhile.
+ * @arg fill The cache to fill; gets the candidates, the best filling and both gains.
+ */
+static void find_filling(Instance *instance, GainEngine *engine, Knapsack *knapsack, Fill *fill) {
+  // a stored video is worth what removing it would cost, any other what adding it would save
+  size_t c = fill->cache;
+  Cache *cache = instance->get_cache(c);
+  fill->videos.clear();
+  fill->sizes.clear();
+  fill->gains.clear();
+  fill->old_gain = 0;
+  Span<const Candidate> candidates = engine->get_candidates(c);
+  for (size_t i = 0; i < candidates.size(); i++) {
+    size_t video = candidates[i].video, size = instance->get_video_size(video);
+    bool stored = cache->has_video(video);
+    uint64_t gain = stored ? engine->get_loss(video, c) : candidates[i].gain;
+    fill->old_gain += stored ? gain : 0;
+    if (gain > 0 && size <= instance->get_cache_size()) {
+      fill->videos.push_back(video);
+      fill->sizes.push_back(size);
+      fill->gains.push_back(gain);
+    }
+  }
+  fill->gain = knapsack->solve(Span<const uint32_t>(fill->sizes.data(), fill->sizes.size()),
+                               Span<const uint64_t>(fill->gains.data(), fill->gains.size()),
+                               instance->get_cache_size(), &fill->chosen);
+}
+
+static void prepare(Instance *instance, Executor *executor, Deadline *deadline) {
+  using namespace std;
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  size_t caches_amt = instance->get_caches_amount();
+
+  // a cache gets the first level after those of all lower caches it shares an endpoint with, the
+  // way the executor batches endpoints; a cache is only filled from what the caches sharing an
+  // endpoint with it store, so the caches of a level can be filled in parallel and the sweep
+  // still ends up where a serial one would
+  vector<uint32_t> level(caches_amt), next_level(instance->get_endpoints_amount(), 0);
+  size_t levels_amt = 0;
+  for (size_t c = 0; c < caches_amt; c++) {
+    Span<const uint32_t> endpoints = instance->get_cache_endpoints(c);
+    for (size_t i = 0; i < endpoints.size(); i++)
+      level[c] = max(level[c], next_level[endpoints[i]]);
+    for (size_t i = 0; i < endpoints.size(); i++)
+      next_level[endpoints[i]] = level[c] + 1;
+    levels_amt = max(levels_amt, (size_t) level[c] + 1);
+  }
+  vector<size_t> level_offset(levels_amt + 1, 0);
+  for (size_t c = 0; c < caches_amt; c++)
+    level_offset[level[c] + 1]++;
+  for (size_t l = 0; l < levels_amt; l++)
+    level_offset[l + 1] += level_offset[l];
+  vector<uint32_t> by_level(caches_amt);
+  vector<size_t> fill_at(level_offset.begin(), level_offset.end() - 1);
+  for (size_t c = 0; c < caches_amt; c++)
+    by_level[fill_at[level[c]]++] = c;
+
+  GainEngine engine(instance);
+  vector<Knapsack> knapsacks(executor->get_threads());
+  vector<Fill> fills;
+  vector<uint32_t> old;
+  vector<uint8_t> dirty(caches_amt, 1);
+  atomic<size_t> next_fill;
+
+  size_t sweeps = 0, solved = 0, improved = 1, changed = 0, candidates_amt = 0;
+  bool out_of_time = false;
+  for (; sweeps < MAX_SWEEPS && improved > 0 && !out_of_time; sweeps++) {
+    improved = 0;
+    for (size_t l = 0; l < levels_amt; l++) {
+      size_t amount = 0;
+      for (size_t i = level_offset[l]; i < level_offset[l + 1]; i++)
+        amount += dirty[by_level[i]];
+      if (amount == 0)
+        continue;
+      if ((out_of_time = deadline->is_over(instance)))
+        break;
+      if (fills.size() < amount)
+        fills.resize(amount);
+      amount = 0;
+      for (size_t i = level_offset[l]; i < level_offset[l + 1]; i++)
+        if (dirty[by_level[i]]) {
+          dirty[by_level[i]] = 0;
+          fills[amount++].cache = by_level[i];
+        }
+
+      // each thread takes caches of the level with its own solver, until none are left
+      next_fill = 0;
+      executor->parallel_for(knapsacks.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; k++)
+          for (size_t f = next_fill++; f < amount; f = next_fill++)
+            find_filling(instance, &engine, &knapsacks[k], &fills[f]);
+      });
+
+      for (size_t f = 0; f < amount; f++) {
+        Fill *fill = &fills[f];
+        size_t c = fill->cache;
+        candidates_amt += fill->videos.size();
+        solved++;
+
+        // only a strictly better filling replaces the old one, so that the sweeps come to an end
+        if (fill->gain <= fill->old_gain)
+          continue;
+        improved++;
+        Cache *cache = instance->get_cache(c);
+        IdMap keep;
+        for (size_t i = 0; i < fill->chosen.size(); i++)
+          keep.insert(fill->videos[fill->chosen[i]], 0);
+        old.clear();
+        Span<Request *const> stored = cache->get_videos();
+        for (size_t i = 0; i < stored.size(); i++)
+          if (keep.find(stored[i]->get_video_id()) == IdMap::EMPTY)
+            old.push_back(stored[i]->get_video_id());
+        for (size_t i = 0; i < old.size(); i++)
+          cache->remove_video(old[i]);
+        for (size_t i = 0; i < fill->chosen.size(); i++)
+          if (!cache->has_video(fill->videos[fill->chosen[i]])) {
+            instance->place_video(c, fill->videos[fill->chosen[i]]);
+            changed++;
+          }
+        changed += old.size();
+
+        // caches sharing an endpoint with this one may find a better filling now
+        Span<const uint32_t> endpoints = instance->get_cache_endpoints(c);
+        for (size_t i = 0; i < endpoints.size(); i++) {
+          Span<const uint32_t> caches = instance->get_link_caches(endpoints[i]);
+          for (size_t j = 0; j < caches.size(); j++)
+            if (caches[j] != c)
+              dirty[caches[j]] = 1;
+        }
+      }
+    }
+  }
+
+  size_t decided = 0;
+  for (size_t k = 0; k < knapsacks.size(); k++)
+    decided += knapsacks[k].get_decided();
+  double time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  fprintf(stderr, "Knapsack:  %lu sweeps, %lu caches filled in %.3f s (%.1f per second, %s, "
+          "%lu levels, %lu threads), %lu videos placed or removed, %lu of %lu decided without "
+          "DP%s\n", sweeps, solved, time, solved / time,
+          Knapsack::is_vectorized() ? "AVX2" : "scalar", levels_amt, knapsacks.size(), changed,
+          decided, candidates_amt, out_of_time ? ", out of time" : "");
+}
+
+static void compute(Endpoint *e, size_t pass) {
+  return;
+}
+
+REGISTER_ALGORITHM(knapsack);
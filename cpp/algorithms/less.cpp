@@ -11,32 +11,36 @@
 
 #include "compute.h"
 
+// compute() depends on the pass number, so every pass has to visit every endpoint
+static const bool pass_independent = false;
+
+// compute() touches nothing but its endpoint and the endpoint's caches
+static const bool endpoint_local = true;
+
+// enough for videos_worth_sharing.in, the slowest of the datasets to fill
+static const size_t passes = 1700;
+
 // set to 200 for kittens.in, and 1 for the others
 const size_t minimum_caches = 1;
 // amount of passes before threshold increases; increasing this also increases the passes needed
 const size_t granularity = 3;
 
-void compute(Endpoint *e, size_t pass) {
-  // get caches
-  Cache **caches;
-  size_t caches_count = e->get_connected_caches(&caches);
-  
-  // get requests
-  Request **requests;
-  size_t requests_count = e->get_stored_requests(&requests);
+static void prepare(Instance *instance, Executor *executor, Deadline *deadline) {
+  return;
+}
+
+static void compute(Endpoint *e, size_t pass) {
+  Span<Cache *const> caches = e->get_caches();
+  Request *top = e->get_top_request();
   
   // push one video (the highest scoring one) to one cache  
-  if (requests_count > 0 && caches_count <= pass / granularity + minimum_caches) {
+  if (top != NULL && caches.size() <= pass / granularity + minimum_caches) {
     size_t c = 0;
-    while (c < caches_count)
-      if (caches[c++]->push_video(e, requests[0]))
+    while (c < caches.size())
+      if (caches[c++]->push_video(e, top))
         break;
   }
-  
-  // cleanup
-  if (caches_count > 0)
-    delete[] caches;
-  if (requests_count > 0)
-    delete[] requests;
   return;
-}
\ No newline at end of file
+}
+
+REGISTER_ALGORITHM(less);
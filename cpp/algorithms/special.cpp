@@ -0,0 +1,215 @@
+//
+// special.cpp
+//   requires 1 pass
+//
+// Solves an instance directly when its links have a special shape (see topology.h), with a
+// solver specialized for that shape, and falls back to the knapsack algorithm otherwise.
+//
+// shared:   a video saves the same in every cache, and only its first copy saves anything. The
+//           value of a video is therefore known up front: the latency it saves, summed over all
+//           endpoints requesting it. The caches are filled one after another, each with the most
+//           valuable set of the videos that are not stored yet (see knapsack.h). This packs the
+//           videos into bins; trend.cpp does the same by hand, for trending_today only.
+// separate: no two caches serve the same endpoint, so each cache is filled once, with the most
+//           valuable set of the videos requested through it. This is the optimal solution.
+//
+// Neither solver needs the GainEngine: values come straight from the inverted demands of the
+// instance, and all sizes come from the instance rather than from what the datasets happen to
+// hold. All of the work happens in prepare(); the per-endpoint passes have nothing left to do.
+// Starting from a solution (-s) always uses the fallback, which continues from there.
+//
+
+#include <chrono>
+#include <stdio.h>
+#include <vector>
+
+#include "compute.h"
+#include "../knapsack.h"
+#include "../topology.h"
+
+// compute() ignores the pass number, so passes only need to revisit endpoints that can change
+static const bool pass_independent = true;
+
+// compute() touches nothing but its endpoint and the endpoint's caches
+static const bool endpoint_local = true;
+
+// runs until nothing changes
+static const size_t passes = 0;
+
+/**
+ * General solver: whatever the shape, the knapsack algorithm applies.
+ * @arg instance The instance to solve.
+ * @arg executor Threads to solve on; only the general solver uses more than one.
+ * @arg deadline When to stop; the solvers stop between caches.
+ * @return Amount of videos placed by the solver itself; 0, since the fallback reports its own.
+ */
+template <Shape S>
+static size_t solve(Instance *instance, Executor *executor, Deadline *deadline) {
+  const Algorithm *fallback = find_algorithm("knapsack");
+  if (fallback)
+    fallback->prepare(instance, executor, deadline);
+  return 0;
+}
+
+/**
+ * Latency saved by one request of a connected endpoint, the same through each of its caches.
+ * @arg instance The instance.
+ * @arg endpoint Endpoint ID.
+ * @return Latency in ms saved per request; 0 if the endpoint has no cache or no faster one.
+ */
+static uint64_t saving_of(Instance *instance, size_t endpoint) {
+  Span<const uint32_t> latencies = instance->get_link_latencies(endpoint);
+  uint32_t datacenter = instance->get_datacenter_latency(endpoint);
+  return latencies.empty() || latencies[0] >= datacenter ? 0 : datacenter - latencies[0];
+}
+
+/**
+ * Shared solver: values videos once, then fills the caches one after another.
+ * @arg instance The instance to solve.
+ * @arg executor Unused; the caches are filled one after another.
+ * @arg deadline When to stop.
+ * @return Amount of videos placed.
+ */
+template <>
+size_t solve<SHAPE_SHARED>(Instance *instance, Executor *executor, Deadline *deadline) {
+  using namespace std;
+  size_t endpoints_amt = instance->get_endpoints_amount(), capacity = instance->get_cache_size();
+  vector<uint64_t> savings(endpoints_amt);
+  size_t first = endpoints_amt;
+  for (size_t e = 0; e < endpoints_amt; e++) {
+    savings[e] = saving_of(instance, e);
+    if (first == endpoints_amt && !instance->get_link_caches(e).empty())
+      first = e;
+  }
+  if (first == endpoints_amt)
+    return 0;
+
+  // the value of a video is the latency saved by all its requests, wherever it is stored
+  vector<uint32_t> videos, sizes, chosen;
+  vector<uint64_t> values;
+  for (size_t v = 0; v < instance->get_videos_amount(); v++) {
+    Span<const uint32_t> endpoints = instance->get_video_endpoints(v);
+    Span<const size_t> weights = instance->get_video_weights(v);
+    uint64_t value = 0;
+    for (size_t i = 0; i < endpoints.size(); i++)
+      value += savings[endpoints[i]] * weights[i];
+    if (value > 0 && instance->get_video_size(v) <= capacity) {
+      videos.push_back(v);
+      sizes.push_back(instance->get_video_size(v));
+      values.push_back(value);
+    }
+  }
+
+  // every cache takes the best set of what is left; the chosen videos are then taken out
+  Knapsack knapsack;
+  Span<const uint32_t> caches = instance->get_link_caches(first);
+  size_t placed = 0;
+  for (size_t c = 0; c < caches.size() && !videos.empty() && !deadline->is_over(instance); c++) {
+    knapsack.solve(Span<const uint32_t>(sizes.data(), sizes.size()),
+                   Span<const uint64_t>(values.data(), values.size()), capacity, &chosen);
+    for (size_t i = 0; i < chosen.size(); i++)
+      placed += instance->place_video(caches[c], videos[chosen[i]]);
+
+    // chosen is ascending, so the videos that stay can be moved down in one sweep
+    size_t kept = 0;
+    for (size_t i = 0, j = 0; i < videos.size(); i++) {
+      if (j < chosen.size() && chosen[j] == i) {
+        j++;
+        continue;
+      }
+      videos[kept] = videos[i];
+      sizes[kept] = sizes[i];
+      values[kept++] = values[i];
+    }
+    videos.resize(kept);
+    sizes.resize(kept);
+    values.resize(kept);
+  }
+  return placed;
+}
+
+/**
+ * Separate solver: values the videos of each cache over its own endpoints, and fills it once.
+ * @arg instance The instance to solve.
+ * @arg executor Unused; the caches are filled one after another.
+ * @arg deadline When to stop.
+ * @return Amount of videos placed.
+ */
+template <>
+size_t solve<SHAPE_SEPARATE>(Instance *instance, Executor *executor, Deadline *deadline) {
+  using namespace std;
+  size_t capacity = instance->get_cache_size(), placed = 0;
+  vector<uint64_t> value_of(instance->get_videos_amount(), 0), values;
+  vector<uint32_t> videos, sizes, chosen;
+  Knapsack knapsack;
+  for (size_t c = 0; c < instance->get_caches_amount() && !deadline->is_over(instance); c++) {
+    // the endpoints of this cache are served by no other cache
+    Span<const uint32_t> endpoints = instance->get_cache_endpoints(c);
+    Span<const uint32_t> latencies = instance->get_cache_latencies(c);
+    for (size_t i = 0; i < endpoints.size(); i++) {
+      uint32_t datacenter = instance->get_datacenter_latency(endpoints[i]);
+      if (latencies[i] >= datacenter)
+        continue;
+      Span<const uint32_t> demands = instance->get_demand_videos(endpoints[i]);
+      Span<const size_t> weights = instance->get_demand_weights(endpoints[i]);
+      for (size_t d = 0; d < demands.size(); d++)
+        value_of[demands[d]] += (uint64_t) (datacenter - latencies[i]) * weights[d];
+    }
+
+    // the cache's videos are listed once each, so the values are collected and reset in one go
+    Span<const uint32_t> requested = instance->get_cache_videos(c);
+    videos.clear();
+    sizes.clear();
+    values.clear();
+    for (size_t i = 0; i < requested.size(); i++) {
+      uint32_t v = requested[i];
+      if (value_of[v] > 0 && instance->get_video_size(v) <= capacity) {
+        videos.push_back(v);
+        sizes.push_back(instance->get_video_size(v));
+        values.push_back(value_of[v]);
+      }
+      value_of[v] = 0;
+    }
+    knapsack.solve(Span<const uint32_t>(sizes.data(), sizes.size()),
+                   Span<const uint64_t>(values.data(), values.size()), capacity, &chosen);
+    for (size_t i = 0; i < chosen.size(); i++)
+      placed += instance->place_video(c, videos[chosen[i]]);
+  }
+  return placed;
+}
+
+static void prepare(Instance *instance, Executor *executor, Deadline *deadline) {
+  using namespace std;
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  Topology topology(instance);
+  Shape shape = topology.get_shape();
+
+  // the solvers assume empty caches
+  for (size_t c = 0; c < instance->get_caches_amount(); c++)
+    if (!instance->get_cache(c)->get_videos().empty())
+      shape = SHAPE_GENERAL;
+  fprintf(stderr, "Topology:  %s shape (%s), %lu of %lu endpoints connected\n",
+          topology.get_shape_name(), topology.get_properties().c_str(), topology.get_connected(),
+          instance->get_endpoints_amount());
+
+  size_t placed = 0;
+  if (shape == SHAPE_SHARED)
+    placed = solve<SHAPE_SHARED>(instance, executor, deadline);
+  else if (shape == SHAPE_SEPARATE)
+    placed = solve<SHAPE_SEPARATE>(instance, executor, deadline);
+  else
+    placed = solve<SHAPE_GENERAL>(instance, executor, deadline);
+
+  double time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  if (shape != SHAPE_GENERAL)
+    fprintf(stderr, "Special:   %s solver placed %lu videos in %.3f s\n",
+            topology.get_shape_name(), placed, time);
+  else
+    fprintf(stderr, "Special:   general fallback (knapsack) took %.3f s\n", time);
+}
+
+static void compute(Endpoint *e, size_t pass) {
+  return;
+}
+
+REGISTER_ALGORITHM(special);
@@ -19,41 +19,67 @@
 //
 // This solution scored 499.959 points (out of a possible 500.000).
 //
+// Other inputs get a valid solution, but no good one. special.cpp recognizes the shape of this
+// dataset in any input (see topology.h) and packs it with a knapsack per cache instead.
+//
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
 
 #include "compute.h"
+#include "../topology.h"
+
+// compute() depends on the pass number, so every pass has to visit every endpoint
+static const bool pass_independent = false;
+
+// every endpoint reads and writes the shared already_cached flags below, so the result depends on
+// the order of all endpoints
+static const bool endpoint_local = false;
+
+// one pass per divisor, and one for the remaining videos
+static const size_t passes = 16;
 
-// once a video id has been cached once, it doesn't need to be cached again
-bool already_cached[10000];
+// once a video id has been cached once, it doesn't need to be cached again; bytes rather than
+// bits, read and written atomically, since endpoints may run on several threads at once (-r)
+static std::vector<uint8_t> already_cached;
 
-void compute(Endpoint *e, size_t pass) {
+static void prepare(Instance *instance, Executor *executor, Deadline *deadline) {
+  // start over when the program runs this algorithm more than once
+  already_cached.assign(instance->get_videos_amount(), 0);
+
+  Topology topology(instance);
+  if (topology.get_shape() != SHAPE_SHARED)
+    fprintf(stderr, "Warning: trend assumes all endpoints share their caches, but this input has "
+            "a %s shape; try -a special\n", topology.get_shape_name());
+}
+
+static void compute(Endpoint *e, size_t pass) {
   // list of divisors
   const size_t divisors[] = {1000, 625, 500, 400, 250, 200, 125, 100, 80, 50, 40, 25, 20, 16, 10};
   
-  // get caches
-  Cache **caches;
-  size_t caches_count = e->get_connected_caches(&caches);
-  
-  // get requests
-  Request **requests;
-  size_t requests_count = e->get_stored_requests(&requests);
+  Span<Cache *const> caches = e->get_caches();
+  Span<Request *const> requests = e->get_requests();
 
   // pass 0-15: perform caching of videos with size divisible by divisors[] array
   if (pass < sizeof divisors / sizeof(size_t)) {
     size_t divisor = divisors[pass];
     
-    for (size_t req = 0; req < requests_count; req++) {
+    for (size_t req = 0; req < requests.size(); req++) {
       Request *v = requests[req];
       
       // reject videos that were previously cached or do not match divisor requirement
-      if (already_cached[v->get_video_id()] || v->get_video_size() % divisor != 0)
+      if (v == NULL || __atomic_load_n(&already_cached[v->get_video_id()], __ATOMIC_RELAXED) ||
+          v->get_video_size() % divisor != 0)
         continue;
       
-      // seek the next cache that has space for this video
-      for (size_t c = 0; c < caches_count; c++) {
+      // seek the next cache that has space for this video; v may be deallocated once pushed
+      size_t video_id = v->get_video_id();
+      for (size_t c = 0; c < caches.size(); c++) {
         if (caches[c]->push_video(e, v)) {
         
           // record the succesful caching of this video
-          already_cached[v->get_video_id()] = true;
+          __atomic_store_n(&already_cached[video_id], 1, __ATOMIC_RELAXED);
           break;
         }
       }
@@ -63,24 +89,23 @@ void compute(Endpoint *e, size_t pass) {
   // pass 16: for the remaining videos requests, just try to place them, in order of appearance
   else {
     // "reversing" this for loop happens to fit +1 video!
-    for (int v = requests_count - 1; v >= 0; v--) {
+    for (int v = requests.size() - 1; v >= 0; v--) {
       // reject already cached videos
-      if (already_cached[requests[v]->get_video_id()])
+      if (requests[v] == NULL ||
+          __atomic_load_n(&already_cached[requests[v]->get_video_id()], __ATOMIC_RELAXED))
         continue;
       
-      // seek next cache that has space for this video
-      for (size_t c = 0; c < caches_count; c++)
+      // seek next cache that has space for this video; pushing it empties the slot
+      size_t video_id = requests[v]->get_video_id();
+      for (size_t c = 0; c < caches.size(); c++)
         if (caches[c]->push_video(e, requests[v])) {
-          already_cached[requests[v]->get_video_id()] = true;
+          __atomic_store_n(&already_cached[video_id], 1, __ATOMIC_RELAXED);
           break;
         }
     }
   } // end of pass 16
 
-  // cleanup
-  if (caches_count > 0)
-    delete[] caches;
-  if (requests_count > 0)
-    delete[] requests;
   return; 
 }
+
+REGISTER_ALGORITHM(trend);
@@ -0,0 +1,99 @@
+/***************************************************************************************************
+ *
+ * arena.cpp
+ * @author Ben Witzen
+ * @date Feb 27, 2017
+ *
+ * Part of my solution for Google's Hashcode 2017 challenge, submitted during the extended round.
+ *
+ * Function descriptions can be found in arena.h
+ *
+ **************************************************************************************************/
+
+#include "arena.h"
+#include "youtube.h"
+
+#include <new>
+#include <stdint.h>
+
+// blocks are taken this much larger, so that any alignment up to it can be met
+static const size_t MAX_ALIGNMENT = 64;
+
+// requests are taken in blocks of this size
+static const size_t REQUEST_BLOCK_SIZE = 1 << 20;
+
+// Arena class
+
+Arena::Arena(size_t block_size) {
+  this->block_size = block_size;
+  next = end = NULL;
+}
+
+Arena::~Arena(void) {
+  for (size_t i = 0; i < blocks.size(); i++)
+    delete[] blocks[i];
+}
+
+void *Arena::allocate(size_t bytes, size_t alignment) {
+  uintptr_t at = ((uintptr_t) next + alignment - 1) & ~(uintptr_t) (alignment - 1);
+  if (next == NULL || at + bytes > (uintptr_t) end) {
+    // a large allocation gets a block of its own, and leaves the current block in use
+    size_t size = bytes > block_size / 2 ? bytes : block_size;
+    char *block = new char[size + MAX_ALIGNMENT];
+    blocks.push_back(block);
+    at = ((uintptr_t) block + alignment - 1) & ~(uintptr_t) (alignment - 1);
+    if (size != block_size)
+      return (void *) at;
+    end = block + size + MAX_ALIGNMENT;
+  }
+  next = (char *) (at + bytes);
+  return (void *) at;
+}
+
+size_t Arena::get_blocks(void) {
+  return blocks.size();
+}
+
+// RequestPool class
+
+RequestPool::RequestPool(void) : arena(REQUEST_BLOCK_SIZE), lock(false) {
+  spares = NULL;
+  created = 0;
+}
+
+RequestPool::~RequestPool(void) {
+}
+
+Request *RequestPool::create(size_t video_id, size_t video_size, size_t weight) {
+  while (lock.exchange(true, std::memory_order_acquire))
+    while (lock.load(std::memory_order_relaxed))
+      ;
+  void *memory;
+  if (spares != NULL) {
+    memory = spares;
+    spares = spares->next;
+  }
+  else
+    memory = arena.allocate(sizeof(Request), alignof(Request));
+  size_t id = created++;
+  lock.store(false, std::memory_order_release);
+  return new (memory) Request(id, video_id, video_size, weight);
+}
+
+void RequestPool::release(Request *request) {
+  Spare *spare = (Spare *) request;
+  while (lock.exchange(true, std::memory_order_acquire))
+    while (lock.load(std::memory_order_relaxed))
+      ;
+  spare->next = spares;
+  spares = spare;
+  lock.store(false, std::memory_order_release);
+}
+
+size_t RequestPool::get_created(void) {
+  return created;
+}
+
+size_t RequestPool::get_blocks(void) {
+  return arena.get_blocks();
+}
@@ -0,0 +1,143 @@
+/***************************************************************************************************
+ *
+ * arena.h
+ * @author Ben Witzen
+ * @date Feb 27, 2017
+ *
+ * Part of my solution for Google's Hashcode 2017 challenge, submitted during the extended round.
+ *
+ * Defines the Arena and the RequestPool, which hold the many small objects of an Instance.
+ *
+ * An Arena hands out memory from a few large blocks by moving a pointer forward, and frees all of
+ * it at once when it is destroyed. It never runs destructors; objects that own memory of their
+ * own must be destroyed by hand before the arena goes. An Arena is not thread-safe.
+ *
+ * A RequestPool creates Request objects in an arena of its own, and takes back the ones that are
+ * merged away, handing them out again before taking new memory. Requests own no memory, so they
+ * are never destroyed one by one: all of them go with the pool. Requests are numbered per pool.
+ * Caches merge requests from several threads at once, so the pool guards itself with a lock.
+ *
+ **************************************************************************************************/
+
+#ifndef _ARENA_H
+#define _ARENA_H
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <stdint.h>
+#include <vector>
+
+// forward declaration
+class Request;
+
+/**
+ * Arena class.
+ */
+class Arena {
+  private:
+    std::vector<char *> blocks;
+    char *next, *end;
+    size_t block_size;
+
+    // arenas own their blocks and cannot be copied
+    Arena(const Arena &);
+    Arena &operator=(const Arena &);
+
+  public:
+    /**
+     * Constructor. Takes no memory until the first allocation.
+     * @arg block_size Size in bytes of the blocks taken for small allocations.
+     */
+    Arena(size_t block_size);
+
+    /**
+     * Destructor.
+     * Frees all blocks at once, without destroying the objects in them.
+     */
+    ~Arena(void);
+
+    /**
+     * @arg bytes Size of the memory.
+     * @arg alignment Alignment of the memory, a power of two up to 64.
+     * @return Uninitialized memory, valid until the arena is destroyed. Allocations larger than
+     *         a block get a block of their own.
+     */
+    void *allocate(size_t bytes, size_t alignment);
+
+    /**
+     * @arg count Amount of objects.
+     * @return Uninitialized memory for an array of objects. Throws std::bad_alloc if the size of
+     *         the array does not fit in a size_t.
+     */
+    template <typename T>
+    T *allocate_array(size_t count) {
+      if (count > SIZE_MAX / sizeof(T))
+        throw std::bad_alloc();
+      return (T *) allocate(count * sizeof(T), alignof(T));
+    }
+
+    /**
+     * @return Amount of blocks taken so far.
+     */
+    size_t get_blocks(void);
+};
+
+/**
+ * RequestPool class.
+ */
+class RequestPool {
+  private:
+    // a request that was given back, with the memory of the request reused as the link
+    struct Spare {
+      Spare *next;
+    };
+
+    Arena arena;
+    Spare *spares;
+    std::atomic<bool> lock;
+    size_t created;
+
+    // pools own their requests and cannot be copied
+    RequestPool(const RequestPool &);
+    RequestPool &operator=(const RequestPool &);
+
+  public:
+    /**
+     * Constructor.
+     */
+    RequestPool(void);
+
+    /**
+     * Destructor.
+     * All Request objects created by this pool are freed with it.
+     */
+    ~RequestPool(void);
+
+    /**
+     * Creates a request.
+     * @arg video_id Video ID of the request.
+     * @arg video_size Size of the video being requested.
+     * @arg weight Weight of the request.
+     * @return The new request, numbered after the ones created before it.
+     */
+    Request *create(size_t video_id, size_t video_size, size_t weight);
+
+    /**
+     * Takes back a request that is no longer used anywhere, so that its memory can be reused.
+     * @arg request A request created by this pool.
+     */
+    void release(Request *request);
+
+    /**
+     * @return Amount of requests created, including those that were taken back.
+     */
+    size_t get_created(void);
+
+    /**
+     * @return Amount of blocks taken by the arena of the pool.
+     */
+    size_t get_blocks(void);
+};
+
+#endif // _ARENA_H
@@ -0,0 +1,230 @@
+/***************************************************************************************************
+ *
+ * bench.cpp
+ * @author Ben Witzen
+ * @date Feb 27, 2017
+ *
+ * Part of my solution for Google's Hashcode 2017 challenge, submitted during the extended round.
+ *
+ * Entry point of the benchmark. Loads an input file and runs the computation like main.cpp does,
+ * timing each phase on its own: parsing the infile, constructing the objects the computation needs
+ * (the Scorer and the Executor), prepare(), the passes, scoring the result from scratch and writing
+ * the outfile, which goes to a temporary file. It reports, for prepare() and every pass, the
+ * endpoints visited, the wall time and the amount of heap allocations made, as counted by a Trace
+ * (see trace.h), and in the end the peak resident set size and the score. Throughput counts the
+ * time of prepare() along with the passes, as some algorithms do all of their work in prepare().
+ *
+ * With -j, the per-pass report is left out and the totals are printed as a single line of JSON,
+ * so that results of several runs can be collected in one file. `make suite` does so for every
+ * algorithm and every input file. Each line names the shape of the input (see topology.h), so
+ * that the gain of the special algorithm can be read off per shape.
+ *
+ * Compile with: make bench [a=example]
+ * Run with ./bench [-a algorithm] [-t threads] [-j] infile [passes]
+ *   -a  name of the algorithm to run; defaults to the algorithm given to make
+ *   -t  threads per pass, in deterministic mode; algorithms that keep state across endpoints
+ *       (see algorithms/compute.h) get one
+ *   without an amount of passes, the algorithm runs the amount it registers (see
+ *   algorithms/compute.h)
+ *
+ **************************************************************************************************/
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <stdio.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "executor.h"
+#include "instance.h"
+#include "scheduler.h"
+#include "scorer.h"
+#include "topology.h"
+#include "trace.h"
+#include "youtube.h"
+#include "algorithms/compute.h"
+
+// commit the benchmark was built from, filled in by make suite
+#ifndef COMMIT
+#define COMMIT "unknown"
+#endif
+
+// algorithm to run without -a, filled in by make bench a=name
+#ifndef ALGORITHM_NAME
+#define ALGORITHM_NAME ""
+#endif
+
+/**
+ * @arg start Start of a phase.
+ * @return Seconds passed since the start.
+ */
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv) {
+  using namespace std;
+
+  // read options
+  const char *program = argv[0], *name = ALGORITHM_NAME;
+  size_t threads = 1;
+  bool json = false;
+  int option;
+  while ((option = getopt(argc, argv, "a:t:j")) != -1) {
+    if (option == 'a')
+      name = optarg;
+    else if (option == 't')
+      threads = atoi(optarg);
+    else if (option == 'j')
+      json = true;
+    else
+      return 1;
+  }
+  argc -= optind - 1;
+  argv += optind - 1;
+
+  // usage instructions
+  if (argc < 2 || !*name) {
+    cerr << "Usage: " << program << " [-a algorithm] [-t threads] [-j] infile [passes]" << endl;
+    return 0;
+  }
+  const Algorithm *algorithm = find_algorithm(name);
+  if (!algorithm) {
+    cerr << "Unknown algorithm: " << name << endl;
+    return 1;
+  }
+
+  // get amount of passes; 0 means until nothing changes, as in main.cpp
+  size_t passes = argc > 2 ? atoi(argv[2]) : algorithm->passes;
+  if (passes == 0 && !algorithm->pass_independent) {
+    cerr << "The amount of passes can only be left open for algorithms that ignore the pass "
+            "number" << endl;
+    return 1;
+  }
+
+  // parse
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  Instance *instance = new Instance();
+  if (!instance->load(argv[1])) {
+    cerr << instance->get_error() << endl;
+    delete instance;
+    return 1;
+  }
+  double parse_time = seconds_since(start);
+
+  // shape of the instance, so that results can be compared per shape (see topology.h)
+  Topology topology(instance);
+
+  // construct the scorer, which has to see everything that gets placed, and the executor, which
+  // prepare() may already run on
+  start = chrono::steady_clock::now();
+  Scorer *scorer = new Scorer(instance);
+  Executor *executor = new Executor(instance, algorithm->endpoint_local ? threads : 1, true);
+  double construct_time = seconds_since(start);
+  threads = executor->get_threads();
+
+  // prepare, measured like a pass, since it does all of the work of some algorithms
+  Trace *trace = new Trace();
+  start = chrono::steady_clock::now();
+  trace->begin_pass();
+  Deadline deadline;
+  algorithm->prepare(instance, executor, &deadline);
+  trace->end_pass(0, 0);
+  double prepare_time = seconds_since(start);
+  size_t prepare_allocations = trace->get_pass_count(ALLOCATIONS);
+
+  // construct the rest, which only depends on the links
+  start = chrono::steady_clock::now();
+  Scheduler *scheduler = new Scheduler(instance, executor, algorithm->pass_independent);
+  construct_time += seconds_since(start);
+
+  // compute, measuring each pass
+  if (!json) {
+    printf("algorithm %s, infile %s (%s shape), %lu threads\n", algorithm->name, argv[1],
+           topology.get_shape_name(), threads);
+    printf("%8s %10s %12s %12s\n", "pass", "visits", "time (ms)", "allocations");
+    printf("%8s %10s %12.3f %12lu\n", "prepare", "", prepare_time * 1000, prepare_allocations);
+  }
+  size_t p = 0, visits = 0, allocations = prepare_allocations;
+  start = chrono::steady_clock::now();
+  while (passes == 0 || p < passes) {
+    trace->begin_pass();
+    algorithm->run_pass(scheduler, p);
+    trace->end_pass(p, scheduler->get_visits());
+    if (!json)
+      printf("%8lu %10lu %12.3f %12lu\n", p, scheduler->get_visits(), trace->get_pass_time(),
+             trace->get_pass_count(ALLOCATIONS));
+    visits += scheduler->get_visits();
+    allocations += trace->get_pass_count(ALLOCATIONS);
+    p++;
+    if (algorithm->pass_independent && scheduler->is_converged())
+      break;
+  }
+  double compute_time = seconds_since(start);
+
+  // throughput of the whole computation, so that algorithms doing their work in prepare() compare
+  // fairly with those doing it in passes
+  double visits_per_s = visits / (prepare_time + compute_time);
+  delete trace;
+  delete scheduler;
+  delete executor;
+
+  // score from scratch, the way score.cpp does
+  start = chrono::steady_clock::now();
+  Scorer *rescorer = new Scorer(instance);
+  uint64_t score = rescorer->get_score();
+  delete rescorer;
+  double score_time = seconds_since(start);
+  if (score != scorer->get_score())
+    cerr << "Warning: incremental score " << scorer->get_score() << " differs from " << score
+         << endl;
+  delete scorer;
+
+  // write
+  start = chrono::steady_clock::now();
+  FILE *out = tmpfile();
+  if (!out) {
+    cerr << "Cannot create a temporary outfile" << endl;
+    delete instance;
+    return 1;
+  }
+  instance->print_raw(out);
+  fflush(out);
+  long output_size = ftell(out);
+  fclose(out);
+  double write_time = seconds_since(start);
+
+  // peak resident set size, which Linux reports in KB
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  double input_mb = instance->get_input_size() / 1e6, peak_mb = usage.ru_maxrss / 1e3;
+
+  if (json)
+    printf("{\"commit\":\"%s\",\"algorithm\":\"%s\",\"infile\":\"%s\",\"shape\":\"%s\","
+           "\"threads\":%lu,\"input_mb\":%.3f,\"passes\":%lu,\"visits\":%lu,\"allocations\":%lu,"
+           "\"prepare_allocations\":%lu,\"parse_s\":%.6f,\"parse_mb_s\":%.1f,\"construct_s\":%.6f,"
+           "\"prepare_s\":%.6f,\"compute_s\":%.6f,\"visits_per_s\":%.0f,\"score_s\":%.6f,"
+           "\"write_s\":%.6f,\"output_mb\":%.3f,\"peak_rss_mb\":%.1f,\"score\":%lu}\n", COMMIT,
+           algorithm->name, argv[1], topology.get_shape_name(), threads, input_mb, p, visits,
+           allocations, prepare_allocations, parse_time, input_mb / parse_time, construct_time,
+           prepare_time, compute_time, visits_per_s, score_time, write_time, output_size / 1e6,
+           peak_mb, score);
+  else {
+    printf("%8s %10lu %12.3f %12lu (%.1f per pass)\n", "total", visits,
+           (prepare_time + compute_time) * 1000, allocations,
+           (allocations - prepare_allocations) / (double) p);
+    printf("parse     %10.3f s (%.1f MB/s)\n", parse_time, input_mb / parse_time);
+    printf("construct %10.3f s\n", construct_time);
+    printf("prepare   %10.3f s\n", prepare_time);
+    printf("compute   %10.3f s (%.0f endpoint visits/s with prepare)\n", compute_time,
+           visits_per_s);
+    printf("score     %10.3f s\n", score_time);
+    printf("write     %10.3f s (%.1f MB)\n", write_time, output_size / 1e6);
+    printf("peak RSS  %10.1f MB\n", peak_mb);
+    printf("score     %10lu\n", score);
+  }
+
+  // cleanup
+  delete instance;
+}
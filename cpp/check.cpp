@@ -0,0 +1,220 @@
+/***************************************************************************************************
+ *
+ * check.cpp
+ * @author Ben Witzen
+ * @date Feb 27, 2017
+ *
+ * Part of my solution for Google's Hashcode 2017 challenge, submitted during the extended round.
+ *
+ * Entry point of the journal check. Loads an input file and makes random moves on its caches, the
+ * way a local search does: a few pushes of lined up requests, placements, removals and returned
+ * requests at a time, recorded by a Journal (see journal.h). Each move is either kept or rolled
+ * back. After every move, the score the Scorer kept up to date must equal the score of the caches
+ * computed from scratch; after every rollback, the videos and remaining space of every cache, the
+ * requests lined up in every endpoint with their positions and weights, and the score must be
+ * those from before the move.
+ *
+ * Then the Search (see search.h), which keeps its own copy of the caches and its own undo, gets
+ * the same treatment from the solution left behind: a searcher makes as many random moves and
+ * undoes most of them, and after each the score and state it keeps must match those of its
+ * contents scored from scratch (see Search::check()).
+ *
+ * Compile with: make check, which also runs it on every official and synthetic input
+ * Run with ./check [-r seed] infile [moves]
+ *   -r  seed of the random generator; default 1
+ *   moves defaults to 1000
+ *
+ **************************************************************************************************/
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <stdint.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <vector>
+
+#include "instance.h"
+#include "journal.h"
+#include "scorer.h"
+#include "search.h"
+#include "youtube.h"
+
+// most changes a single move makes
+static const size_t MAX_CHANGES = 8;
+
+/**
+ * What a rollback has to restore: the sorted videos and the remaining space of every cache, and
+ * the position, video and weight of every request lined up in an endpoint.
+ */
+struct State {
+  std::vector<std::vector<size_t> > videos;
+  std::vector<size_t> remaining;
+  std::vector<std::vector<size_t> > requests;
+  uint64_t score;
+
+  bool operator==(const State &other) const {
+    return videos == other.videos && remaining == other.remaining &&
+           requests == other.requests && score == other.score;
+  }
+};
+
+/**
+ * Takes the state of an instance.
+ * @arg instance The instance.
+ * @arg score Score of its caches.
+ * @return The state.
+ */
+static State take_state(Instance *instance, uint64_t score) {
+  State state;
+  state.videos.resize(instance->get_caches_amount());
+  state.remaining.resize(instance->get_caches_amount());
+  for (size_t c = 0; c < instance->get_caches_amount(); c++) {
+    Span<Request *const> stored = instance->get_cache(c)->get_videos();
+    for (size_t i = 0; i < stored.size(); i++)
+      state.videos[c].push_back(stored[i]->get_video_id());
+    std::sort(state.videos[c].begin(), state.videos[c].end());
+    state.remaining[c] = instance->get_cache(c)->get_remaining_space();
+  }
+  state.requests.resize(instance->get_endpoints_amount());
+  for (size_t e = 0; e < instance->get_endpoints_amount(); e++) {
+    Endpoint *endpoint = instance->get_endpoint(e);
+    Span<Request *const> requests = endpoint->get_requests();
+    for (size_t i = 0; i < requests.size(); i++)
+      if (requests[i] != NULL) {
+        state.requests[e].push_back(endpoint->find_slot(requests[i]->get_video_id()));
+        state.requests[e].push_back(requests[i]->get_video_id());
+        state.requests[e].push_back(requests[i]->get_weight());
+      }
+  }
+  state.score = score;
+  return state;
+}
+
+/**
+ * Makes one random change to the caches of an instance; changes that are not possible, such as a
+ * push into a full cache, change nothing.
+ * @arg instance The instance.
+ * @arg random Random generator to draw from.
+ */
+static void change(Instance *instance, std::mt19937_64 &random) {
+  Cache *cache = instance->get_cache(random() % instance->get_caches_amount());
+  Span<Request *const> stored = cache->get_videos();
+  size_t kind = random() % 4;
+
+  // push a request lined up in an endpoint into one of its caches
+  if (kind == 0) {
+    Endpoint *endpoint = instance->get_endpoint(random() % instance->get_endpoints_amount());
+    Span<Request *const> requests = endpoint->get_requests();
+    Span<Cache *const> caches = endpoint->get_caches();
+    if (requests.size() > 0 && caches.size() > 0) {
+      Request *request = requests[random() % requests.size()];
+      if (request != NULL)
+        caches[random() % caches.size()]->push_video(endpoint, request);
+    }
+  }
+
+  // place a video on behalf of every endpoint
+  else if (kind == 1)
+    instance->place_video(cache->get_id(), random() % instance->get_videos_amount());
+
+  // remove a stored video, or return the latest request merged into it
+  else if (stored.size() > 0) {
+    size_t video = stored[random() % stored.size()]->get_video_id();
+    if (kind == 2)
+      cache->remove_video(video);
+    else
+      cache->return_request(video);
+  }
+}
+
+int main(int argc, char **argv) {
+  using namespace std;
+
+  // read options
+  const char *program = argv[0];
+  size_t seed = 1;
+  int option;
+  while ((option = getopt(argc, argv, "r:")) != -1) {
+    if (option == 'r')
+      seed = atoi(optarg);
+    else
+      return 1;
+  }
+  argc -= optind - 1;
+  argv += optind - 1;
+
+  // usage instructions
+  if (argc < 2) {
+    cerr << "Usage: " << program << " [-r seed] infile [moves]" << endl;
+    return 0;
+  }
+  size_t moves = argc > 2 ? atoi(argv[2]) : 1000;
+
+  // read infile
+  Instance *instance = new Instance();
+  if (!instance->load(argv[1])) {
+    cerr << instance->get_error() << endl;
+    delete instance;
+    return 1;
+  }
+  if (instance->get_caches_amount() == 0 || instance->get_endpoints_amount() == 0 ||
+      instance->get_videos_amount() == 0) {
+    cerr << argv[1] << ": nothing to check" << endl;
+    delete instance;
+    return 0;
+  }
+
+  // move, and keep a quarter of the moves so that rollbacks start from all kinds of contents
+  Scorer *scorer = new Scorer(instance);
+  Journal *journal = new Journal(instance);
+  mt19937_64 random(seed);
+  State before = take_state(instance, scorer->get_score());
+  size_t kept = 0, changes = 0, failures = 0;
+  for (size_t m = 0; m < moves && failures == 0; m++) {
+    size_t mark = journal->get_mark();
+    for (size_t i = random() % MAX_CHANGES; i < MAX_CHANGES; i++)
+      change(instance, random);
+    changes += journal->get_size() - mark;
+
+    Scorer *rescorer = new Scorer(instance);
+    if (rescorer->get_score() != scorer->get_score()) {
+      cerr << "Move " << m << ": score " << scorer->get_score() << ", but "
+           << rescorer->get_score() << " from scratch" << endl;
+      failures++;
+    }
+    delete rescorer;
+
+    if (random() % 4 == 0) {
+      journal->commit();
+      before = take_state(instance, scorer->get_score());
+      kept++;
+      continue;
+    }
+    journal->rollback(mark);
+    rescorer = new Scorer(instance);
+    if (!(take_state(instance, scorer->get_score()) == before) ||
+        rescorer->get_score() != before.score) {
+      cerr << "Move " << m << ": rollback did not restore the state before it" << endl;
+      failures++;
+    }
+    delete rescorer;
+  }
+
+  printf("%s: %lu moves, %lu kept, %lu changes recorded, %s\n", argv[1], moves, kept, changes,
+         failures == 0 ? "OK" : "FAILED");
+
+  // the search undoes its moves on its own copy of the caches
+  Search *search = new Search(instance, 1);
+  size_t search_failures = search->check(moves, seed);
+  printf("%s: %lu search moves, %lu not matching a rescoring from scratch, %s\n", argv[1], moves,
+         search_failures, search_failures == 0 ? "OK" : "FAILED");
+  failures += search_failures;
+  delete search;
+
+  // cleanup
+  delete journal;
+  delete scorer;
+  delete instance;
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,179 @@
+/***************************************************************************************************
+ *
+ * checkpoint.cpp
+ * @author Ben Witzen
+ * @date Feb 27, 2017
+ *
+ * Part of my solution for Google's Hashcode 2017 challenge, submitted during the extended round.
+ *
+ * Function descriptions can be found in checkpoint.h
+ *
+ **************************************************************************************************/
+
+#include "checkpoint.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <stdio.h>
+#include <unistd.h>
+
+typedef std::chrono::steady_clock Clock;
+
+// the writing thread looks at the termination flag this often while it waits
+static const std::chrono::milliseconds POLL(100);
+
+// set by the signal handler; the only thing a handler can safely do
+static volatile sig_atomic_t terminated = 0;
+
+static void on_termination(int signal) {
+  terminated = 1;
+}
+
+Checkpoint::Checkpoint(const char *path, double interval) : path(path), interval(interval) {
+  temporary = this->path + ".tmp";
+  best_score = 0;
+  offered = unwritten = stopping = failed = false;
+  writes = 0;
+  last_offer = Clock::now();
+  writer = std::thread(&Checkpoint::run, this);
+}
+
+Checkpoint::~Checkpoint(void) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+    unwritten = false;
+  }
+  wake.notify_one();
+  if (writer.joinable())
+    writer.join();
+}
+
+void Checkpoint::catch_termination(void) {
+  struct sigaction action;
+  memset(&action, 0, sizeof action);
+  action.sa_handler = on_termination;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGTERM, &action, NULL);
+}
+
+void Checkpoint::run(void) {
+  std::vector<std::vector<uint32_t> > contents;
+  Clock::time_point next = Clock::now();
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    wake.wait_for(lock, POLL);
+
+    // write what there is and end the program; the other threads are left as they are
+    if (terminated) {
+      bool write_now = unwritten;
+      contents = best;
+      lock.unlock();
+      if (write_now && !write(contents))
+        fprintf(stderr, "Terminated; %s\n", error.c_str());
+      else if (offered)
+        fprintf(stderr, "Terminated; %s holds the best solution, which scores %lu\n",
+                path.c_str(), best_score);
+      else
+        fprintf(stderr, "Terminated before any solution was found\n");
+      _exit(128 + SIGTERM);
+    }
+
+    bool ending = stopping;
+    if (unwritten && (ending || Clock::now() >= next)) {
+      contents = best;
+      unwritten = false;
+      lock.unlock();
+      bool written = write(contents);
+      lock.lock();
+      failed = !written;
+      writes += written;
+      next = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                std::chrono::duration<double>(interval));
+    }
+    if (ending)
+      return;
+  }
+}
+
+bool Checkpoint::write(const std::vector<std::vector<uint32_t> > &contents) {
+  FILE *f = fopen(temporary.c_str(), "w");
+  if (!f) {
+    error = "Cannot open " + temporary + ": " + strerror(errno);
+    return false;
+  }
+  fprintf(f, "%lu\n", contents.size());
+  for (size_t c = 0; c < contents.size(); c++) {
+    fprintf(f, "%lu", c);
+    for (size_t i = 0; i < contents[c].size(); i++)
+      fprintf(f, " %u", contents[c][i]);
+    fprintf(f, "\n");
+  }
+
+  // the data must be on disk before the rename makes it the outfile
+  bool written = fflush(f) == 0 && fsync(fileno(f)) == 0;
+  written = fclose(f) == 0 && written;
+  if (!written || rename(temporary.c_str(), path.c_str()) != 0) {
+    error = "Cannot write " + path + ": " + strerror(errno);
+    remove(temporary.c_str());
+    return false;
+  }
+  return true;
+}
+
+void Checkpoint::offer(Instance *instance, uint64_t score) {
+  std::lock_guard<std::mutex> lock(mutex);
+  last_offer = Clock::now();
+  if (offered && score < best_score)
+    return;
+  best.resize(instance->get_caches_amount());
+  for (size_t c = 0; c < best.size(); c++) {
+    Span<Request *const> videos = instance->get_cache(c)->get_videos();
+    best[c].clear();
+    for (size_t i = 0; i < videos.size(); i++)
+      best[c].push_back(videos[i]->get_video_id());
+  }
+  best_score = score;
+  offered = unwritten = true;
+}
+
+void Checkpoint::improved(const std::vector<std::vector<uint32_t> > &contents, uint64_t score) {
+  std::lock_guard<std::mutex> lock(mutex);
+  last_offer = Clock::now();
+  if (offered && score < best_score)
+    return;
+  best = contents;
+  best_score = score;
+  offered = unwritten = true;
+}
+
+bool Checkpoint::is_due(void) {
+  std::lock_guard<std::mutex> lock(mutex);
+  return Clock::now() - last_offer >= std::chrono::duration<double>(interval);
+}
+
+bool Checkpoint::finish(void) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wake.notify_one();
+  if (writer.joinable())
+    writer.join();
+  return !failed;
+}
+
+size_t Checkpoint::get_writes(void) {
+  std::lock_guard<std::mutex> lock(mutex);
+  return writes;
+}
+
+uint64_t Checkpoint::get_score(void) {
+  std::lock_guard<std::mutex> lock(mutex);
+  return best_score;
+}
+
+const char *Checkpoint::get_error(void) {
+  return error.c_str();
+}
@@ -0,0 +1,136 @@
+/***************************************************************************************************
+ *
+ * checkpoint.h
+ * @author Ben Witzen
+ * @date Feb 27, 2017
+ *
+ * Part of my solution for Google's Hashcode 2017 challenge, submitted during the extended round.
+ *
+ * Defines the Checkpoint, which keeps the outfile up to date with the best solution found so far
+ * while the program is still computing, so that a job that is stopped keeps its work.
+ *
+ * Solutions are offered to the checkpoint by the thread that drives the computation, between
+ * passes or between epochs of the search, and only one at least as good as before is kept, as a
+ * copy of the video IDs stored by every cache. Writing happens on a thread of its own, at most
+ * once per interval and only if a solution came in, so the threads that compute never wait for
+ * the disk. Each write goes to a temporary file next to the outfile, which is renamed over the
+ * outfile once it is complete: the outfile always holds a whole solution, the old or the new one.
+ *
+ * Once catch_termination() was called, SIGTERM makes the writing thread write the best solution
+ * it has right away and end the program, with the exit status a shell gives a process killed by
+ * SIGTERM. Solutions offered since the last one it took are lost, so an interval that is short
+ * compared to the time the job gets notice of being killed loses little.
+ *
+ **************************************************************************************************/
+
+#ifndef _CHECKPOINT_H
+#define _CHECKPOINT_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "instance.h"
+#include "search.h"
+
+/**
+ * Checkpoint class.
+ */
+class Checkpoint : public SearchListener {
+  private:
+    std::string path, temporary, error;
+    double interval;
+    std::vector<std::vector<uint32_t> > best;
+    uint64_t best_score;
+    bool offered, unwritten, stopping, failed;
+    size_t writes;
+    std::chrono::steady_clock::time_point last_offer;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::thread writer;
+
+    /**
+     * Main loop of the writing thread.
+     */
+    void run(void);
+
+    /**
+     * Writes a solution to the temporary file and renames it over the outfile.
+     * @arg contents IDs of the videos stored by every cache.
+     * @return true on success, false on failure (see get_error()).
+     */
+    bool write(const std::vector<std::vector<uint32_t> > &contents);
+
+    // checkpoints own their thread and cannot be copied
+    Checkpoint(const Checkpoint &);
+    Checkpoint &operator=(const Checkpoint &);
+
+  public:
+    /**
+     * Constructor. Starts the writing thread, which writes nothing until a solution is offered.
+     * @arg path Path to the outfile.
+     * @arg interval Time in seconds between two writes, at least.
+     */
+    Checkpoint(const char *path, double interval);
+
+    /**
+     * Destructor. Stops the writing thread without writing what it has not written yet; see
+     * finish().
+     */
+    ~Checkpoint(void);
+
+    /**
+     * Makes SIGTERM write the best solution and end the program, as described above. Only one
+     * checkpoint can catch it.
+     */
+    void catch_termination(void);
+
+    /**
+     * Offers the videos currently stored in the caches of an instance, which the caller must not
+     * change meanwhile. Nothing is copied if the solution is worse than the best one so far.
+     * @arg instance The instance whose caches to take.
+     * @arg score Score of the solution.
+     */
+    void offer(Instance *instance, uint64_t score);
+
+    /**
+     * Offers a solution found by a Search; see SearchListener.
+     * @arg contents IDs of the videos stored by every cache.
+     * @arg score Score of the solution.
+     */
+    void improved(const std::vector<std::vector<uint32_t> > &contents, uint64_t score);
+
+    /**
+     * @return true if an interval has passed since a solution was last offered, so that the
+     *         caller can offer solutions about as often as they get written.
+     */
+    bool is_due(void);
+
+    /**
+     * Stops the writing thread, after it wrote the best solution if it had not done so yet.
+     * @return true on success, false if the last write failed (see get_error()).
+     */
+    bool finish(void);
+
+    /**
+     * @return Amount of solutions written so far.
+     */
+    size_t get_writes(void);
+
+    /**
+     * @return Score of the best solution offered so far.
+     */
+    uint64_t get_score(void);
+
+    /**
+     * @return Description of the last failure.
+     */
+    const char *get_error(void);
+};
+
+#endif // _CHECKPOINT_H
@@ -0,0 +1,115 @@
+/***************************************************************************************************
+ *
+ * components.cpp
+ * @author Ben Witzen
+ * @date Feb 27, 2017
+ *
+ * Part of my solution for Google's Hashcode 2017 challenge, submitted during the extended round.
+ *
+ * Function descriptions can be found in components.h
+ *
+ **************************************************************************************************/
+
+#include "components.h"
+
+#include <algorithm>
+
+// finds the representative of a cache, halving the path along the way
+static uint32_t find(std::vector<uint32_t> &parent, uint32_t cache) {
+  while (parent[cache] != cache) {
+    parent[cache] = parent[parent[cache]];
+    cache = parent[cache];
+  }
+  return cache;
+}
+
+Components::Components(Instance *instance) {
+  size_t endpoints_amt = instance->get_endpoints_amount();
+  size_t caches_amt = instance->get_caches_amount();
+
+  // join the caches of every endpoint
+  std::vector<uint32_t> parent(caches_amt);
+  for (size_t c = 0; c < caches_amt; c++)
+    parent[c] = c;
+  for (size_t e = 0; e < endpoints_amt; e++) {
+    Span<const uint32_t> links = instance->get_link_caches(e);
+    for (size_t i = 1; i < links.size(); i++) {
+      uint32_t a = find(parent, links[0]), b = find(parent, links[i]);
+      if (a != b)
+        parent[std::max(a, b)] = std::min(a, b);
+    }
+  }
+
+  // number the components by their root cache; one extra for endpoints without caches
+  const uint32_t NONE = UINT32_MAX;
+  std::vector<uint32_t> label(caches_amt + 1, NONE), endpoint_label(endpoints_amt);
+  std::vector<size_t> endpoint_count, cache_count;
+  for (size_t c = 0; c <= caches_amt; c++) {
+    uint32_t root = c < caches_amt ? find(parent, c) : caches_amt;
+    if (label[root] == NONE) {
+      label[root] = endpoint_count.size();
+      endpoint_count.push_back(0);
+      cache_count.push_back(0);
+      work.push_back(0);
+    }
+    if (c < caches_amt)
+      cache_count[label[root]]++;
+  }
+  for (size_t e = 0; e < endpoints_amt; e++) {
+    Span<const uint32_t> links = instance->get_link_caches(e);
+    uint32_t k = label[links.empty() ? caches_amt : find(parent, links[0])];
+    endpoint_label[e] = k;
+    endpoint_count[k]++;
+    work[k] += links.size() + instance->get_demand_videos(e).size();
+  }
+
+  // order the components from most to least work; drop empty ones
+  std::vector<uint32_t> order;
+  for (size_t k = 0; k < work.size(); k++)
+    if (endpoint_count[k] > 0 || cache_count[k] > 0)
+      order.push_back(k);
+  std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+    return work[a] > work[b];
+  });
+  std::vector<uint32_t> rank(work.size(), NONE);
+  std::vector<size_t> sorted_work(order.size());
+  for (size_t r = 0; r < order.size(); r++) {
+    rank[order[r]] = r;
+    sorted_work[r] = work[order[r]];
+  }
+  work.swap(sorted_work);
+
+  // lay out the endpoints and caches of each component consecutively, in ascending order
+  endpoint_offset.assign(order.size() + 1, 0);
+  cache_offset.assign(order.size() + 1, 0);
+  for (size_t r = 0; r < order.size(); r++) {
+    endpoint_offset[r + 1] = endpoint_offset[r] + endpoint_count[order[r]];
+    cache_offset[r + 1] = cache_offset[r] + cache_count[order[r]];
+  }
+  endpoints.resize(endpoints_amt);
+  caches.resize(caches_amt);
+  std::vector<size_t> fill(endpoint_offset.begin(), endpoint_offset.end() - 1);
+  for (size_t e = 0; e < endpoints_amt; e++)
+    endpoints[fill[rank[endpoint_label[e]]]++] = e;
+  fill.assign(cache_offset.begin(), cache_offset.end() - 1);
+  for (size_t c = 0; c < caches_amt; c++)
+    caches[fill[rank[label[find(parent, c)]]]++] = c;
+}
+
+size_t Components::get_amount(void) {
+  return work.size();
+}
+
+Span<const uint32_t> Components::get_endpoints(size_t component) {
+  return Span<const uint32_t>(endpoints.data() + endpoint_offset[component],
+                              endpoint_offset[component + 1] - endpoint_offset[component]);
+}
+
+Span<const uint32_t> Components::get_caches(size_t component) {
+  return Span<const uint32_t>(caches.data() + cache_offset[component],
+                              cache_offset[component + 1] - cache_offset[component]);
+}
+
+size_t Components::get_work(size_t component) {
+  return work[component];
+}
@@ -0,0 +1,67 @@
+/***************************************************************************************************
+ *
+ * components.h
+ * @author Ben Witzen
+ * @date Feb 27, 2017
+ *
+ * Part of my solution for Google's Hashcode 2017 challenge, submitted during the extended round.
+ *
+ * Defines Components, which splits the graph of endpoints and the caches they are connected to
+ * into connected components. Endpoints in different components share no cache, directly or
+ * through other endpoints, so each component can be solved on its own: with a small working set,
+ * and on its own thread. Endpoints without any cache are gathered in one component of their own.
+ *
+ * Components are ordered from the most to the least work (links plus requests of their endpoints),
+ * so that handing them out in order starts the biggest ones first.
+ *
+ **************************************************************************************************/
+
+#ifndef _COMPONENTS_H
+#define _COMPONENTS_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+#include "instance.h"
+
+/**
+ * Components class.
+ */
+class Components {
+  private:
+    std::vector<size_t> endpoint_offset, cache_offset, work;
+    std::vector<uint32_t> endpoints, caches;
+
+  public:
+    /**
+     * Constructor. Finds the components of an instance.
+     * @arg instance The instance to split.
+     */
+    Components(Instance *instance);
+
+    /**
+     * @return Amount of components.
+     */
+    size_t get_amount(void);
+
+    /**
+     * @arg component Component number; 0 is the biggest component.
+     * @return IDs of the endpoints in the component, in ascending order.
+     */
+    Span<const uint32_t> get_endpoints(size_t component);
+
+    /**
+     * @arg component Component number; 0 is the biggest component.
+     * @return IDs of the caches in the component, in ascending order.
+     */
+    Span<const uint32_t> get_caches(size_t component);
+
+    /**
+     * @arg component Component number; 0 is the biggest component.
+     * @return Amount of links plus requests of the endpoints in the component.
+     */
+    size_t get_work(size_t component);
+};
+
+#endif // _COMPONENTS_H
@@ -0,0 +1,90 @@
+/***************************************************************************************************
+ *
+ * convert.cpp
+ * @author Ben Witzen
+ * @date Feb 27, 2017
+ *
+ * Part of my solution for Google's Hashcode 2017 challenge, submitted during the extended round.
+ *
+ * Entry point of the converter. Loads an input file and writes it as a snapshot (see snapshot.h),
+ * which ./run, ./bench and ./score accept in place of the input file and load without parsing.
+ * With --verify, it instead checks a snapshot against its checksum, which loading one skips, and
+ * loads it as the other programs would.
+ *
+ * Compile with: make convert
+ * Run with ./convert infile snapshot
+ *       or ./convert --verify snapshot
+ *
+ **************************************************************************************************/
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <stdio.h>
+
+#include "instance.h"
+#include "snapshot.h"
+
+/**
+ * Checks a snapshot: its checksum, and everything loading it checks.
+ * @arg path Path to the snapshot.
+ * @return Exit status: 0 if the snapshot is intact, 1 otherwise.
+ */
+static int verify(const char *path) {
+  using namespace std;
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  Snapshot *snapshot = new Snapshot();
+  bool intact = snapshot->open(path) && snapshot->verify();
+  if (!intact)
+    cerr << snapshot->get_error() << endl;
+  delete snapshot;
+  if (!intact)
+    return 1;
+
+  Instance *instance = new Instance();
+  intact = instance->load(path);
+  if (!intact)
+    cerr << instance->get_error() << endl;
+  delete instance;
+  if (intact)
+    fprintf(stderr, "Verified %s in %.3f s\n", path,
+            chrono::duration<double>(chrono::steady_clock::now() - start).count());
+  return intact ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+  using namespace std;
+
+  // usage instructions
+  if (argc < 3) {
+    cerr << "Usage: " << argv[0] << " infile snapshot" << endl;
+    cerr << "   or: " << argv[0] << " --verify snapshot" << endl;
+    return 0;
+  }
+  if (strcmp(argv[1], "--verify") == 0)
+    return verify(argv[2]);
+
+  // read infile
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  Instance *instance = new Instance();
+  if (!instance->load(argv[1])) {
+    cerr << instance->get_error() << endl;
+    delete instance;
+    return 1;
+  }
+  double load_time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+  // write snapshot
+  start = chrono::steady_clock::now();
+  if (!instance->save_snapshot(argv[2])) {
+    cerr << instance->get_error() << endl;
+    delete instance;
+    return 1;
+  }
+  double save_time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  fprintf(stderr, "Loaded %s in %.3f s, wrote %s in %.3f s\n", argv[1], load_time, argv[2],
+          save_time);
+
+  // cleanup
+  delete instance;
+}
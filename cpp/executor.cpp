@@ -0,0 +1,131 @@
+/***************************************************************************************************
+ *
+ * executor.cpp
+ * @author Ben Witzen
+ * @date Feb 27, 2017
+ *
+ * Part of my solution for Google's Hashcode 2017 challenge, submitted during the extended round.
+ *
+ * Function descriptions can be found in executor.h
+ *
+ **************************************************************************************************/
+
+#include "executor.h"
+
+#include <algorithm>
+
+// ThreadPool class
+
+ThreadPool::ThreadPool(size_t threads) {
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  count = chunk = generation = busy = 0;
+  stopping = false;
+  next = 0;
+  for (size_t i = 1; i < threads; i++)
+    workers.push_back(std::thread(&ThreadPool::worker, this));
+}
+
+ThreadPool::~ThreadPool(void) {
+  {
+    std::lock_guard<std::mutex> guard(mutex);
+    stopping = true;
+  }
+  wake.notify_all();
+  for (size_t i = 0; i < workers.size(); i++)
+    workers[i].join();
+}
+
+void ThreadPool::work(void) {
+  for (;;) {
+    size_t begin = next.fetch_add(chunk);
+    if (begin >= count)
+      return;
+    body(begin, std::min(begin + chunk, count));
+  }
+}
+
+void ThreadPool::worker(void) {
+  size_t seen = 0;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> guard(mutex);
+      wake.wait(guard, [this, seen] { return stopping || generation != seen; });
+      if (stopping)
+        return;
+      seen = generation;
+    }
+    work();
+    {
+      std::lock_guard<std::mutex> guard(mutex);
+      if (--busy == 0)
+        done.notify_one();
+    }
+  }
+}
+
+void ThreadPool::parallel_for(size_t count, size_t chunk,
+                              const std::function<void(size_t, size_t)> &body) {
+  if (workers.empty() || count <= chunk) {
+    body(0, count);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(mutex);
+    this->body = body;
+    this->count = count;
+    this->chunk = chunk;
+    next = 0;
+    busy = workers.size();
+    generation++;
+  }
+  wake.notify_all();
+  work();
+
+  std::unique_lock<std::mutex> guard(mutex);
+  done.wait(guard, [this] { return busy == 0; });
+}
+
+size_t ThreadPool::get_threads(void) {
+  return workers.size() + 1;
+}
+
+// Executor class
+
+Executor::Executor(Instance *instance, size_t threads, bool deterministic) : pool(threads) {
+  this->instance = instance;
+  this->deterministic = deterministic;
+
+  // an endpoint's batch is the one after the latest batch of a lower endpoint sharing a cache;
+  // after[c] is one past the latest batch that uses cache c, 0 if none does yet
+  size_t endpoints_amt = instance->get_endpoints_amount();
+  std::vector<uint32_t> after(instance->get_caches_amount(), 0);
+  all.resize(endpoints_amt);
+  batch_of.resize(endpoints_amt);
+  batches_amt = 0;
+  for (size_t e = 0; e < endpoints_amt; e++) {
+    Span<const uint32_t> caches = instance->get_link_caches(e);
+    uint32_t batch = 0;
+    for (size_t i = 0; i < caches.size(); i++)
+      batch = std::max(batch, after[caches[i]]);
+    for (size_t i = 0; i < caches.size(); i++)
+      after[caches[i]] = batch + 1;
+    all[e] = e;
+    batch_of[e] = batch;
+    batches_amt = std::max(batches_amt, (size_t) batch + 1);
+  }
+}
+
+void Executor::parallel_for(size_t count, size_t chunk,
+                            const std::function<void(size_t, size_t)> &body) {
+  pool.parallel_for(count, chunk, body);
+}
+
+size_t Executor::get_batches_amount(void) {
+  return batches_amt;
+}
+
+size_t Executor::get_threads(void) {
+  return pool.get_threads();
+}
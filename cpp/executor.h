@@ -0,0 +1,216 @@
+/***************************************************************************************************
+ *
+ * executor.h
+ * @author Ben Witzen
+ * @date Feb 27, 2017
+ *
+ * Part of my solution for Google's Hashcode 2017 challenge, submitted during the extended round.
+ *
+ * Defines the two objects that run passes on several threads.
+ *
+ * `ThreadPool`: A fixed set of worker threads that split a range of indices between them. The
+ * calling thread works along, so a pool of one thread runs everything on the caller.
+ *
+ * `Executor`: Runs one pass of a compute() function over all endpoints of an Instance, in one of
+ * two modes. In deterministic mode, endpoints are put into batches of endpoints that share no
+ * cache; the endpoints of a batch run in parallel and the batches run one after another. Each
+ * endpoint goes into the first batch after those of all lower endpoints it shares a cache with,
+ * however far back that is, so any two endpoints that share a cache still run in serial order.
+ * Endpoints that share no cache cannot influence each other, so the result is exactly that of a
+ * serial pass, provided compute() touches nothing but its endpoint and the endpoint's caches.
+ * Algorithms declare so with endpoint_local (see algorithms/compute.h); the program and the bench
+ * give those that do not a single thread in deterministic mode. Instances where every endpoint
+ * shares a cache with the one before it (such as trending_today, where all share all caches)
+ * leave nothing to run in parallel this way; relaxed mode or components (below) are the way to
+ * use several threads on those. In relaxed mode all endpoints of a pass run in parallel, and the
+ * order in which endpoints sharing a cache get to push videos is left to chance.
+ *
+ * Alternatively, an Executor can run all passes at once, one connected component (see
+ * components.h) at a time per thread, biggest component first. Components share no cache, so this
+ * also reproduces the serial result under the same proviso.
+ *
+ **************************************************************************************************/
+
+#ifndef _EXECUTOR_H
+#define _EXECUTOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "components.h"
+#include "instance.h"
+#include "youtube.h"
+
+/**
+ * ThreadPool class.
+ */
+class ThreadPool {
+  private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    std::function<void(size_t, size_t)> body;
+    std::atomic<size_t> next;
+    size_t count, chunk, generation, busy;
+    bool stopping;
+
+    /**
+     * Claims chunks of the current range and runs the body on them, until none are left.
+     */
+    void work(void);
+
+    /**
+     * Main loop of a worker thread.
+     */
+    void worker(void);
+
+    // pools own their threads and cannot be copied
+    ThreadPool(const ThreadPool &);
+    ThreadPool &operator=(const ThreadPool &);
+
+  public:
+    /**
+     * Constructor.
+     * @arg threads Amount of threads to run on, including the calling thread; 0 means one per core.
+     */
+    ThreadPool(size_t threads);
+
+    /**
+     * Destructor. Stops and joins the worker threads.
+     */
+    ~ThreadPool(void);
+
+    /**
+     * Runs body(begin, end) over consecutive chunks of [0, count), spread over all threads, and
+     * returns once every chunk is done.
+     * @arg count Size of the range.
+     * @arg chunk Amount of indices claimed at once.
+     * @arg body Function to run on each chunk.
+     */
+    void parallel_for(size_t count, size_t chunk, const std::function<void(size_t, size_t)> &body);
+
+    /**
+     * @return Amount of threads, including the calling thread.
+     */
+    size_t get_threads(void);
+};
+
+/**
+ * Executor class.
+ */
+class Executor {
+  private:
+    Instance *instance;
+    ThreadPool pool;
+    bool deterministic;
+    size_t batches_amt;
+    std::vector<uint32_t> all, batch_of, sorted;
+    std::vector<size_t> batch_offset;
+
+  public:
+    /**
+     * Constructor.
+     * @arg instance The instance whose endpoints to run.
+     * @arg threads Amount of threads to run on; 0 means one per core.
+     * @arg deterministic true to reproduce the result of a serial pass, false for throughput.
+     */
+    Executor(Instance *instance, size_t threads, bool deterministic);
+
+    /**
+     * Calls visit(id) once for each of a list of endpoints, spread over the threads as described
+     * above for a pass.
+     * @arg endpoints IDs of the endpoints to visit, in ascending order.
+     * @arg visit Function to call with each endpoint ID.
+     */
+    template <typename Visit>
+    void run(Span<const uint32_t> endpoints, const Visit &visit) {
+      std::function<void(size_t, size_t)> body = [&endpoints, &visit](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+          visit(endpoints[i]);
+      };
+
+      // a single thread, or a batch per endpoint, gains nothing from the pool
+      if (pool.get_threads() == 1 || (deterministic && batches_amt == all.size()))
+        body(0, endpoints.size());
+      else if (!deterministic)
+        pool.parallel_for(endpoints.size(), 64, body);
+      else {
+        // sort the endpoints by batch, keeping them in order within a batch
+        batch_offset.assign(batches_amt + 1, 0);
+        for (size_t i = 0; i < endpoints.size(); i++)
+          batch_offset[batch_of[endpoints[i]] + 1]++;
+        for (size_t b = 0; b < batches_amt; b++)
+          batch_offset[b + 1] += batch_offset[b];
+        sorted.resize(endpoints.size());
+        for (size_t i = 0; i < endpoints.size(); i++)
+          sorted[batch_offset[batch_of[endpoints[i]]]++] = endpoints[i];
+
+        // batch_offset[b] now marks the end of batch b
+        for (size_t b = 0, first = 0; b < batches_amt; first = batch_offset[b++]) {
+          const uint32_t *batch = sorted.data() + first;
+          pool.parallel_for(batch_offset[b] - first, 16, [batch, &visit](size_t begin,
+                                                                         size_t end) {
+            for (size_t i = begin; i < end; i++)
+              visit(batch[i]);
+          });
+        }
+      }
+    }
+
+    /**
+     * Runs one pass: calls F once for every endpoint.
+     * @arg pass Pass number, handed to F.
+     */
+    template <void (*F)(Endpoint *, size_t)>
+    void run_pass(size_t pass) {
+      Instance *instance = this->instance;
+      run(Span<const uint32_t>(all.data(), all.size()), [instance, pass](size_t e) {
+        F(instance->get_endpoint(e), pass);
+      });
+    }
+
+    /**
+     * Runs all passes, component by component: every thread takes the biggest component left and
+     * runs all passes over its endpoints.
+     * @arg components The components of the instance.
+     * @arg passes Amount of passes.
+     */
+    template <void (*F)(Endpoint *, size_t)>
+    void run_components(Components *components, size_t passes) {
+      Instance *instance = this->instance;
+      pool.parallel_for(components->get_amount(), 1, [=](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; k++) {
+          Span<const uint32_t> endpoints = components->get_endpoints(k);
+          for (size_t p = 0; p < passes; p++)
+            for (size_t i = 0; i < endpoints.size(); i++)
+              F(instance->get_endpoint(endpoints[i]), p);
+        }
+      });
+    }
+
+    /**
+     * Runs body(begin, end) over chunks of [0, count) on the threads of the executor, for work
+     * other than passes, such as that of prepare(); see ThreadPool.
+     * @arg count Size of the range.
+     * @arg chunk Amount of indices claimed at once.
+     * @arg body Function to run on each chunk.
+     */
+    void parallel_for(size_t count, size_t chunk, const std::function<void(size_t, size_t)> &body);
+
+    /**
+     * @return Amount of batches a deterministic pass is cut into.
+     */
+    size_t get_batches_amount(void);
+
+    /**
+     * @return Amount of threads.
+     */
+    size_t get_threads(void);
+};
+
+#endif // _EXECUTOR_H
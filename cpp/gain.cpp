@@ -0,0 +1,160 @@
+/***************************************************************************************************
+ *
+ * gain.cpp
+ * @author Ben Witzen
+ * @date Feb 27, 2017
+ *
+ * Part of my solution for Google's Hashcode 2017 challenge, submitted during the extended round.
+ *
+ * Function descriptions can be found in gain.h
+ *
+ **************************************************************************************************/
+
+#include "gain.h"
+
+GainEngine::GainEngine(Instance *instance) {
+  this->instance = instance;
+  updates = 0;
+
+  size_t caches_amt = instance->get_caches_amount();
+  candidates.resize(caches_amt);
+  positions.resize(caches_amt);
+
+  // initially each request is served from the datacenter, so every faster cache would help
+  best_latency.resize(instance->get_demands_amount());
+  for (size_t e = 0; e < instance->get_endpoints_amount(); e++) {
+    uint32_t latency = instance->get_datacenter_latency(e);
+    Span<const uint32_t> videos = instance->get_demand_videos(e);
+    Span<const size_t> weights = instance->get_demand_weights(e);
+    Span<const uint32_t> caches = instance->get_link_caches(e);
+    Span<const uint32_t> latencies = instance->get_link_latencies(e);
+    size_t first = instance->get_first_demand(e);
+
+    for (size_t i = 0; i < videos.size(); i++) {
+      best_latency[first + i] = latency;
+      for (size_t c = 0; c < caches.size() && latencies[c] < latency; c++)
+        gain_of(caches[c], videos[i]) += (uint64_t) weights[i] * (latency - latencies[c]);
+    }
+  }
+
+  // account for videos that are already cached, then follow the caches
+  for (size_t c = 0; c < caches_amt; c++) {
+    Span<Request *const> videos = instance->get_cache(c)->get_videos();
+    for (size_t i = 0; i < videos.size(); i++)
+      add(c, videos[i]->get_video_id());
+  }
+  updates = 0;
+  instance->add_listener(this);
+}
+
+GainEngine::~GainEngine(void) {
+  instance->remove_listener(this);
+}
+
+uint64_t &GainEngine::gain_of(size_t cache, size_t video) {
+  uint32_t position = positions[cache].find(video);
+  if (position == IdMap::EMPTY) {
+    position = candidates[cache].size();
+    positions[cache].insert(video, position);
+    Candidate candidate = {(uint32_t) video, 0};
+    candidates[cache].push_back(candidate);
+  }
+  return candidates[cache][position].gain;
+}
+
+uint64_t GainEngine::get_gain(size_t video, size_t cache) {
+  uint32_t position = positions[cache].find(video);
+  return position == IdMap::EMPTY ? 0 : candidates[cache][position].gain;
+}
+
+uint64_t GainEngine::get_loss(size_t video, size_t cache) {
+  Span<const uint32_t> endpoints = instance->get_cache_endpoints(cache);
+  Span<const uint32_t> latencies = instance->get_cache_latencies(cache);
+  if (!instance->get_cache(cache)->has_video(video))
+    return 0;
+
+  // endpoints that get the video from this cache would fall back to their next best source
+  auto others_store = [this, cache](size_t other, size_t video) {
+    return other != cache && instance->get_cache(other)->has_video(video);
+  };
+  uint64_t loss = 0;
+  for (size_t i = 0; i < endpoints.size(); i++) {
+    uint32_t d = instance->find_demand(endpoints[i], video);
+    if (d == IdMap::EMPTY || latencies[i] != best_latency[d])
+      continue;
+    uint32_t next = instance->find_fallback_latency(endpoints[i], video, others_store);
+    loss += (uint64_t) instance->get_demand_weight(d) * (next - latencies[i]);
+  }
+  return loss;
+}
+
+Span<const Candidate> GainEngine::get_candidates(size_t cache) {
+  return Span<const Candidate>(candidates[cache].data(), candidates[cache].size());
+}
+
+void GainEngine::add(size_t cache, size_t video) {
+  Span<const uint32_t> endpoints = instance->get_cache_endpoints(cache);
+  Span<const uint32_t> latencies = instance->get_cache_latencies(cache);
+
+  for (size_t i = 0; i < endpoints.size(); i++) {
+    uint32_t d = instance->find_demand(endpoints[i], video);
+    if (d == IdMap::EMPTY || latencies[i] >= best_latency[d])
+      continue;
+
+    // the endpoint now gets the video faster; every cache of the endpoint that was faster than
+    // its old best latency loses (part of) its gain for this video
+    uint32_t old_best = best_latency[d], new_best = latencies[i];
+    uint64_t weight = instance->get_demand_weight(d);
+    Span<const uint32_t> caches = instance->get_link_caches(endpoints[i]);
+    Span<const uint32_t> link_latencies = instance->get_link_latencies(endpoints[i]);
+    for (size_t c = 0; c < caches.size() && link_latencies[c] < old_best; c++) {
+      uint32_t after = link_latencies[c] < new_best ? new_best - link_latencies[c] : 0;
+      gain_of(caches[c], video) -= weight * (old_best - link_latencies[c] - after);
+      updates++;
+    }
+    best_latency[d] = new_best;
+  }
+}
+
+void GainEngine::remove(size_t cache, size_t video) {
+  Span<const uint32_t> endpoints = instance->get_cache_endpoints(cache);
+  Span<const uint32_t> latencies = instance->get_cache_latencies(cache);
+  auto stores = [this](size_t cache, size_t video) {
+    return instance->get_cache(cache)->has_video(video);
+  };
+
+  for (size_t i = 0; i < endpoints.size(); i++) {
+    uint32_t d = instance->find_demand(endpoints[i], video);
+    if (d == IdMap::EMPTY || latencies[i] != best_latency[d])
+      continue;
+
+    // the endpoint falls back to the fastest other cache storing the video, or the datacenter
+    uint32_t old_best = best_latency[d];
+    uint32_t new_best = instance->find_fallback_latency(endpoints[i], video, stores);
+    if (new_best == old_best)
+      continue;
+
+    // every cache of the endpoint that is faster than the new best latency gains what add() took
+    uint64_t weight = instance->get_demand_weight(d);
+    Span<const uint32_t> caches = instance->get_link_caches(endpoints[i]);
+    Span<const uint32_t> link_latencies = instance->get_link_latencies(endpoints[i]);
+    for (size_t c = 0; c < caches.size() && link_latencies[c] < new_best; c++) {
+      uint32_t before = link_latencies[c] < old_best ? old_best - link_latencies[c] : 0;
+      gain_of(caches[c], video) += weight * (new_best - link_latencies[c] - before);
+      updates++;
+    }
+    best_latency[d] = new_best;
+  }
+}
+
+size_t GainEngine::get_updates(void) {
+  return updates;
+}
+
+void GainEngine::video_added(Cache *cache, Request *video) {
+  add(cache->get_id(), video->get_video_id());
+}
+
+void GainEngine::video_removed(Cache *cache, size_t video_id, Span<Endpoint *const> returned) {
+  remove(cache->get_id(), video_id);
+}
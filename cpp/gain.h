@@ -0,0 +1,127 @@
+/***************************************************************************************************
+ *
+ * gain.h
+ * @author Ben Witzen
+ * @date Feb 27, 2017
+ *
+ * Part of my solution for Google's Hashcode 2017 challenge, submitted during the extended round.
+ *
+ * Defines the GainEngine, which knows for every (video, cache) pair how much placing the video in
+ * the cache would improve the solution: the latency it would save, summed over all endpoints that
+ * are connected to the cache and request the video, weighted by their requests. Unlike the score
+ * of a Request, this accounts for the datacenter latency, the latency of the cache, and for any
+ * faster cache that already stores the video.
+ *
+ * Only pairs that can have a gain at all (some connected endpoint requests the video) are stored.
+ * The engine registers itself with every Cache; when a video is placed, only the endpoints
+ * connected to that cache, and the caches connected to those endpoints, are updated; removing a
+ * video updates the same pairs in reverse. Unlike the Scorer, the engine is meant for
+ * single-threaded use.
+ *
+ **************************************************************************************************/
+
+#ifndef _GAIN_H
+#define _GAIN_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+#include "idmap.h"
+#include "instance.h"
+#include "youtube.h"
+
+/**
+ * A video that could be placed in a cache, with the latency it would save.
+ */
+struct Candidate {
+  uint32_t video;
+  uint64_t gain;
+};
+
+/**
+ * GainEngine class.
+ */
+class GainEngine : public CacheListener {
+  private:
+    Instance *instance;
+    std::vector<uint32_t> best_latency;
+    std::vector<std::vector<Candidate> > candidates;
+    std::vector<IdMap> positions;
+    size_t updates;
+
+    /**
+     * @arg cache Cache ID.
+     * @arg video Video ID.
+     * @return Reference to the gain of the pair, which is created if absent.
+     */
+    uint64_t &gain_of(size_t cache, size_t video);
+
+  public:
+    /**
+     * Constructor. Computes the gains for the videos currently stored in the caches of the
+     * instance, and keeps following the caches from then on.
+     * @arg instance The instance to compute gains for.
+     */
+    GainEngine(Instance *instance);
+
+    /**
+     * Destructor. Stops following the caches of the instance.
+     */
+    ~GainEngine(void);
+
+    /**
+     * @arg video Video ID.
+     * @arg cache Cache ID.
+     * @return Weighted latency in ms that placing the video in the cache would save.
+     */
+    uint64_t get_gain(size_t video, size_t cache);
+
+    /**
+     * @arg video Video ID.
+     * @arg cache Cache ID.
+     * @return Weighted latency in ms that removing the video from the cache would cost; 0 if the
+     *         cache does not store the video.
+     */
+    uint64_t get_loss(size_t video, size_t cache);
+
+    /**
+     * @arg cache Cache ID.
+     * @return All videos requested by endpoints connected to the cache, with their gains. Videos
+     *         that are no longer worth placing have a gain of 0. The span remains valid until the
+     *         next video is placed.
+     */
+    Span<const Candidate> get_candidates(size_t cache);
+
+    /**
+     * Accounts for a video that became available in a cache. Adding a video twice has no effect.
+     * @arg cache Cache ID.
+     * @arg video Video ID.
+     */
+    void add(size_t cache, size_t video);
+
+    /**
+     * Accounts for a video that is no longer available in a cache; the cache must not store the
+     * video anymore.
+     * @arg cache Cache ID.
+     * @arg video Video ID.
+     */
+    void remove(size_t cache, size_t video);
+
+    /**
+     * @return Amount of gains changed since the engine was created, excluding the initial ones.
+     */
+    size_t get_updates(void);
+
+    /**
+     * Notification from a cache; see CacheListener.
+     */
+    void video_added(Cache *cache, Request *video);
+
+    /**
+     * Notification from a cache; see CacheListener.
+     */
+    void video_removed(Cache *cache, size_t video_id, Span<Endpoint *const> returned);
+};
+
+#endif // _GAIN_H
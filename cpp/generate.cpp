@@ -0,0 +1,407 @@
+/***************************************************************************************************
+ *
+ * generate.cpp
+ * @author Ben Witzen
+ * @date Feb 27, 2017
+ *
+ * Part of my solution for Google's Hashcode 2017 challenge, submitted during the extended round.
+ *
+ * Entry point of the instance generator. Writes a random input file in the Hashcode format, of any
+ * size, for testing the parser and the algorithms at scale.
+ *
+ * The shape of an instance is set by a preset, which mimics one of the official datasets, and
+ * options that override single parameters. Every endpoint is connected to a uniformly chosen
+ * amount of distinct caches in [k min, k max]. Latencies, video sizes and request weights are
+ * uniform in their ranges; a cache is always faster than the datacenter. Request lines pick an
+ * endpoint uniformly and a video following a Zipf law: the video of popularity rank r is picked
+ * with a probability proportional to 1 / r^z, where z = 0 gives uniform popularity. Ranks are
+ * spread over the video IDs by a fixed permutation, so the popular videos are not all at the
+ * start.
+ *
+ * The file is written while it is generated; nothing but a write buffer and the caches of one
+ * endpoint is kept in memory, so files of many GB can be written with a few MB of memory. The
+ * same options and seed always give the same file.
+ *
+ * Compile with: make generate
+ * Run with ./generate [-p preset] [-x scale] [-r seed] [options] outfile
+ *   -p  me_at_the_zoo, videos_worth_spreading, trending_today or kittens; default
+ *       videos_worth_spreading. The kittens preset is modelled on the task description, as
+ *       the input file is not available.
+ *   -x  multiply the amounts of videos, endpoints and request lines by this factor
+ *   -r  seed of the random generator; default 1
+ *   -V, -E, -R, -C, -X  amounts of videos, endpoints, request lines and caches, cache capacity
+ *   -k, -s, -d, -l, -w  ranges min:max of caches per endpoint, video sizes, datacenter latencies,
+ *       cache latencies and request weights
+ *   -z  Zipf exponent of video popularity
+ * Use - as outfile to write to standard output.
+ *
+ **************************************************************************************************/
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <unistd.h>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * Parameters that describe the shape of an instance.
+ */
+struct Shape {
+  const char *name;
+  uint64_t videos, endpoints, requests, caches, capacity;
+  uint64_t k_min, k_max, size_min, size_max, ld_min, ld_max, lc_min, lc_max, w_min, w_max;
+  double zipf;
+};
+
+// shapes of the official datasets, as measured from the input files; kittens follows the task
+// description
+static const Shape presets[] = {
+  {"me_at_the_zoo", 100, 10, 100, 10, 100, 1, 5, 1, 50, 200, 1300, 2, 250, 1, 1000, 1.0},
+  {"videos_worth_spreading", 10000, 100, 100000, 100, 10000, 0, 10, 1, 600, 10, 2000, 1, 200,
+   1, 10000, 1.0},
+  {"trending_today", 10000, 100, 100000, 100, 50000, 100, 100, 88, 1000, 600, 600, 100, 100, 1,
+   10000, 0.0},
+  {"kittens", 10000, 1000, 200000, 500, 6000, 0, 500, 1, 1000, 500, 4000, 1, 500, 1, 10000, 0.8}
+};
+
+/**
+ * Buffered writer of unsigned numbers, separated by spaces and newlines.
+ */
+class Writer {
+  private:
+    FILE *f;
+    std::vector<char> buffer;
+    size_t used, written;
+
+  public:
+    /**
+     * Constructor.
+     * @arg f C-style FILE pointer to write into.
+     */
+    Writer(FILE *f) : f(f), buffer(1 << 20), used(0), written(0) {
+    }
+
+    /**
+     * Writes out whatever is buffered.
+     * @return false if writing failed.
+     */
+    bool flush(void) {
+      bool ok = fwrite(buffer.data(), 1, used, f) == used;
+      written += used;
+      used = 0;
+      return ok;
+    }
+
+    /**
+     * Appends a number followed by a separator, flushing when the buffer is full.
+     * @arg value Number to write.
+     * @arg separator Character that follows the number.
+     * @return false if writing failed.
+     */
+    bool put(uint64_t value, char separator) {
+      if (used + 24 > buffer.size() && !flush())
+        return false;
+      char digits[20];
+      size_t n = 0;
+      do {
+        digits[n++] = '0' + value % 10;
+        value /= 10;
+      } while (value);
+      while (n)
+        buffer[used++] = digits[--n];
+      buffer[used++] = separator;
+      return true;
+    }
+
+    /**
+     * @return Amount of bytes written so far, including the buffered ones.
+     */
+    size_t get_written(void) {
+      return written + used;
+    }
+};
+
+/**
+ * Samples ranks 1..n following a Zipf law with exponent z > 0 in constant time and memory, by
+ * rejection-inversion (Hörmann and Derflinger, 1996).
+ */
+class Zipf {
+  private:
+    double n, z, h_x1, h_n, s;
+
+    /**
+     * @arg x A rank.
+     * @return Unnormalized probability of the rank, 1 / x^z.
+     */
+    double h(double x) {
+      return exp(-z * log(x));
+    }
+
+    /**
+     * @arg x A number.
+     * @return log1p(x) / x, continued to 1 at 0.
+     */
+    static double helper1(double x) {
+      return fabs(x) > 1e-8 ? log1p(x) / x : 1 - x * (0.5 - x * (1.0 / 3 - 0.25 * x));
+    }
+
+    /**
+     * @arg x A number.
+     * @return expm1(x) / x, continued to 1 at 0.
+     */
+    static double helper2(double x) {
+      return fabs(x) > 1e-8 ? expm1(x) / x : 1 + x * 0.5 * (1 + x / 3 * (1 + 0.25 * x));
+    }
+
+    /**
+     * @arg x A number.
+     * @return The integral of h from 1 to x.
+     */
+    double h_integral(double x) {
+      double log_x = log(x);
+      return helper2((1 - z) * log_x) * log_x;
+    }
+
+    /**
+     * @arg x A number.
+     * @return The inverse of h_integral() at x.
+     */
+    double h_integral_inverse(double x) {
+      double t = x * (1 - z);
+      if (t < -1)
+        t = -1;
+      return exp(helper1(t) * x);
+    }
+
+  public:
+    /**
+     * Constructor.
+     * @arg n Amount of ranks.
+     * @arg z Exponent.
+     */
+    Zipf(uint64_t n, double z) : n(n), z(z) {
+      h_x1 = h_integral(1.5) - 1;
+      h_n = h_integral(n + 0.5);
+      s = 2 - h_integral_inverse(h_integral(2.5) - h(2));
+    }
+
+    /**
+     * @arg random Random generator to draw from.
+     * @return A rank in [1, n].
+     */
+    template <typename Random>
+    uint64_t sample(Random &random) {
+      std::uniform_real_distribution<double> uniform(0, 1);
+      while (true) {
+        double u = h_n + uniform(random) * (h_x1 - h_n);
+        double x = h_integral_inverse(u);
+        double k = floor(x + 0.5);
+        if (k < 1)
+          k = 1;
+        else if (k > n)
+          k = n;
+        if (k - x <= s || u >= h_integral(k + 0.5) - h(k))
+          return (uint64_t) k;
+      }
+    }
+};
+
+/**
+ * Reads a range option of the form min:max.
+ * @arg text Option argument.
+ * @arg min Gets overwritten with the lower bound.
+ * @arg max Gets overwritten with the upper bound.
+ * @return false if the text is not a range.
+ */
+static bool read_range(const char *text, uint64_t *min, uint64_t *max) {
+  char *end;
+  *min = strtoull(text, &end, 10);
+  if (*end != ':')
+    return false;
+  *max = strtoull(end + 1, &end, 10);
+  return *end == '\0' && *min <= *max;
+}
+
+/**
+ * @arg a A number.
+ * @arg b Another number.
+ * @return Greatest common divisor of both.
+ */
+static uint64_t gcd(uint64_t a, uint64_t b) {
+  while (b) {
+    uint64_t t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+/**
+ * Writes an instance.
+ * @arg shape Shape of the instance.
+ * @arg seed Seed of the random generator.
+ * @arg writer Writer to write into.
+ * @return false if writing failed.
+ */
+static bool generate(const Shape &shape, uint64_t seed, Writer *writer) {
+  std::mt19937_64 random(seed);
+  typedef std::uniform_int_distribution<uint64_t> Uniform;
+  bool ok = true;
+
+  // header and video sizes
+  ok &= writer->put(shape.videos, ' ') && writer->put(shape.endpoints, ' ') &&
+        writer->put(shape.requests, ' ') && writer->put(shape.caches, ' ') &&
+        writer->put(shape.capacity, '\n');
+  Uniform size(shape.size_min, shape.size_max);
+  for (uint64_t v = 0; v < shape.videos && ok; v++)
+    ok &= writer->put(size(random), v + 1 < shape.videos ? ' ' : '\n');
+
+  // endpoints, each with distinct caches picked by Floyd's algorithm
+  Uniform k(shape.k_min, shape.k_max), ld(shape.ld_min, shape.ld_max);
+  std::unordered_set<uint64_t> picked;
+  std::vector<uint64_t> order;
+  for (uint64_t e = 0; e < shape.endpoints && ok; e++) {
+    uint64_t latency = ld(random), links = k(random);
+    picked.clear();
+    order.clear();
+    for (uint64_t j = shape.caches - links; j < shape.caches; j++) {
+      uint64_t c = Uniform(0, j)(random);
+      c = picked.insert(c).second ? c : j;
+      picked.insert(c);
+      order.push_back(c);
+    }
+    ok &= writer->put(latency, ' ') && writer->put(links, '\n');
+    uint64_t lc_max = std::min(shape.lc_max, latency - 1);
+    Uniform lc(std::min(shape.lc_min, lc_max), lc_max);
+    for (size_t i = 0; i < order.size() && ok; i++)
+      ok &= writer->put(order[i], ' ') && writer->put(lc(random), '\n');
+  }
+
+  // request lines; popularity ranks map to video IDs by rank * stride + offset (mod videos)
+  uint64_t stride = (uint64_t) (shape.videos * 0.618) | 1;
+  uint64_t offset = Uniform(0, shape.videos - 1)(random);
+  while (gcd(stride, shape.videos) != 1)
+    stride += 2;
+  Zipf zipf(shape.videos, shape.zipf);
+  Uniform endpoint(0, shape.endpoints - 1), video(0, shape.videos - 1);
+  Uniform weight(shape.w_min, shape.w_max);
+  for (uint64_t r = 0; r < shape.requests && ok; r++) {
+    uint64_t v = shape.zipf > 0 ? ((zipf.sample(random) - 1) % shape.videos * stride + offset) %
+                                  shape.videos : video(random);
+    ok &= writer->put(v, ' ') && writer->put(endpoint(random), ' ') &&
+          writer->put(weight(random), '\n');
+  }
+  return ok && writer->flush();
+}
+
+int main(int argc, char **argv) {
+  using namespace std;
+
+  // read options
+  const char *program = argv[0];
+  Shape shape = presets[1];
+  double scale = 1;
+  uint64_t seed = 1;
+  bool ranges_ok = true;
+  int option;
+  while ((option = getopt(argc, argv, "p:x:r:V:E:R:C:X:k:s:d:l:w:z:")) != -1) {
+    if (option == 'p') {
+      size_t i = 0;
+      while (i < sizeof presets / sizeof(Shape) && strcmp(presets[i].name, optarg) != 0)
+        i++;
+      if (i == sizeof presets / sizeof(Shape)) {
+        cerr << "Unknown preset " << optarg << endl;
+        return 1;
+      }
+      shape = presets[i];
+    }
+    else if (option == 'x')
+      scale = atof(optarg);
+    else if (option == 'r')
+      seed = strtoull(optarg, NULL, 10);
+    else if (option == 'V')
+      shape.videos = strtoull(optarg, NULL, 10);
+    else if (option == 'E')
+      shape.endpoints = strtoull(optarg, NULL, 10);
+    else if (option == 'R')
+      shape.requests = strtoull(optarg, NULL, 10);
+    else if (option == 'C')
+      shape.caches = strtoull(optarg, NULL, 10);
+    else if (option == 'X')
+      shape.capacity = strtoull(optarg, NULL, 10);
+    else if (option == 'k')
+      ranges_ok &= read_range(optarg, &shape.k_min, &shape.k_max);
+    else if (option == 's')
+      ranges_ok &= read_range(optarg, &shape.size_min, &shape.size_max);
+    else if (option == 'd')
+      ranges_ok &= read_range(optarg, &shape.ld_min, &shape.ld_max);
+    else if (option == 'l')
+      ranges_ok &= read_range(optarg, &shape.lc_min, &shape.lc_max);
+    else if (option == 'w')
+      ranges_ok &= read_range(optarg, &shape.w_min, &shape.w_max);
+    else if (option == 'z')
+      shape.zipf = atof(optarg);
+    else
+      return 1;
+  }
+  argc -= optind - 1;
+  argv += optind - 1;
+
+  // usage instructions
+  if (argc < 2) {
+    cerr << "Usage: " << program << " [-p preset] [-x scale] [-r seed] [-V videos] [-E endpoints]"
+            " [-R requests] [-C caches] [-X capacity] [-k min:max] [-s min:max] [-d min:max]"
+            " [-l min:max] [-w min:max] [-z exponent] outfile" << endl;
+    return 0;
+  }
+
+  // check the shape
+  shape.videos = llround(shape.videos * scale);
+  shape.endpoints = llround(shape.endpoints * scale);
+  shape.requests = llround(shape.requests * scale);
+  shape.k_max = min(shape.k_max, shape.caches);
+  shape.k_min = min(shape.k_min, shape.k_max);
+  const char *problem = !ranges_ok ? "a range is not of the form min:max with min <= max" :
+      shape.videos == 0 || shape.endpoints == 0 ? "there must be at least one video and endpoint" :
+      max(max(shape.videos, shape.endpoints), max(shape.requests, shape.caches)) > UINT32_MAX ?
+      "amounts must fit in 32 bits" :
+      shape.size_min == 0 ? "videos must be at least 1 MB" :
+      shape.ld_min < 2 ? "datacenter latencies must be at least 2 ms, to leave room for caches" :
+      shape.zipf < 0 ? "the Zipf exponent cannot be negative" : NULL;
+  if (problem) {
+    cerr << "Invalid shape: " << problem << endl;
+    return 1;
+  }
+
+  // write outfile
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  bool to_stdout = strcmp(argv[1], "-") == 0;
+  FILE *out = to_stdout ? stdout : fopen(argv[1], "w");
+  if (!out) {
+    cerr << "Cannot open " << argv[1] << endl;
+    return 1;
+  }
+  Writer *writer = new Writer(out);
+  bool ok = generate(shape, seed, writer);
+  if (!to_stdout)
+    ok &= fclose(out) == 0;
+  if (!ok) {
+    cerr << "Cannot write " << argv[1] << endl;
+    delete writer;
+    return 1;
+  }
+
+  double time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  fprintf(stderr, "Wrote %.1f MB in %.3f s (%.1f MB/s)\n", writer->get_written() / 1e6, time,
+          writer->get_written() / 1e6 / time);
+
+  // cleanup
+  delete writer;
+}
@@ -0,0 +1,169 @@
+/***************************************************************************************************
+ *
+ * idmap.h
+ * @author Ben Witzen
+ * @date Feb 27, 2017
+ *
+ * Part of my solution for Google's Hashcode 2017 challenge, submitted during the extended round.
+ *
+ * Defines IdMap, a small hash table from 32-bit IDs to 32-bit values. It uses open addressing
+ * with linear probing in a single array, so a lookup usually touches one cache line, and removes
+ * entries by shifting back the entries that follow, so no tombstones build up.
+ *
+ **************************************************************************************************/
+
+#ifndef _IDMAP_H
+#define _IDMAP_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * IdMap class.
+ */
+class IdMap {
+  private:
+    struct Entry {
+      uint32_t key, value;
+    };
+
+    std::vector<Entry> table;
+    size_t count, mask;
+    unsigned shift;
+
+    /**
+     * Fibonacci hashing: the high bits of the product depend on all bits of the key, so keys that
+     * only differ above the size of the table still spread out.
+     * @arg key Key to hash.
+     * @return Preferred position of the key in the table.
+     */
+    size_t home(uint32_t key) const {
+      return (uint32_t) (key * 2654435769u) >> shift;
+    }
+
+    /**
+     * Moves all keys into a table of another size.
+     * @arg size New size of the table, a power of two that fits all keys.
+     */
+    void rehash(size_t size) {
+      std::vector<Entry> old;
+      old.swap(table);
+      Entry empty = {EMPTY, 0};
+      table.assign(size, empty);
+      mask = table.size() - 1;
+      for (shift = 32; ((size_t) 1 << (32 - shift)) < size; shift--)
+        ;
+      count = 0;
+      for (size_t i = 0; i < old.size(); i++)
+        if (old[i].key != EMPTY)
+          insert(old[i].key, old[i].value);
+    }
+
+    /**
+     * Doubles the size of the table, or creates the initial table.
+     */
+    void grow(void) {
+      rehash(table.empty() ? 8 : table.size() * 2);
+    }
+
+  public:
+    // key reserved for empty positions, also returned by find() if a key is absent
+    static const uint32_t EMPTY = UINT32_MAX;
+
+    /**
+     * Constructor. Creates an empty map; no memory is allocated until the first insert.
+     */
+    IdMap(void) : count(0), mask(0), shift(32) {
+    }
+
+    /**
+     * @arg key Key to look up.
+     * @return Value stored for the key, or EMPTY if the key is absent.
+     */
+    uint32_t find(uint32_t key) const {
+      if (table.empty())
+        return EMPTY;
+      for (size_t i = home(key);; i = (i + 1) & mask) {
+        if (table[i].key == key)
+          return table[i].value;
+        if (table[i].key == EMPTY)
+          return EMPTY;
+      }
+    }
+
+    /**
+     * Stores a value for a key, replacing any value stored before.
+     * @arg key Key, which must not be EMPTY.
+     * @arg value Value to store.
+     */
+    void insert(uint32_t key, uint32_t value) {
+      if ((count + 1) * 2 > table.size())
+        grow();
+      size_t i = home(key);
+      for (; table[i].key != EMPTY; i = (i + 1) & mask)
+        if (table[i].key == key) {
+          table[i].value = value;
+          return;
+        }
+      table[i].key = key;
+      table[i].value = value;
+      count++;
+    }
+
+    /**
+     * Removes a key and its value, if present.
+     * @arg key Key to remove.
+     * @return true if the key was present.
+     */
+    bool erase(uint32_t key) {
+      if (table.empty())
+        return false;
+      size_t i = home(key);
+      for (; table[i].key != key; i = (i + 1) & mask)
+        if (table[i].key == EMPTY)
+          return false;
+
+      // shift back any following entries that would otherwise become unreachable
+      for (size_t j = (i + 1) & mask; table[j].key != EMPTY; j = (j + 1) & mask) {
+        size_t h = home(table[j].key);
+        if (((j - h) & mask) >= ((j - i) & mask)) {
+          table[i] = table[j];
+          i = j;
+        }
+      }
+      table[i].key = EMPTY;
+      count--;
+      return true;
+    }
+
+    /**
+     * Sizes the table so that an amount of keys can be stored without growing it again.
+     * @arg amount Amount of keys.
+     */
+    void reserve(size_t amount) {
+      size_t size = table.empty() ? 8 : table.size();
+      while (amount * 2 > size)
+        size *= 2;
+      if (size > table.size())
+        rehash(size);
+    }
+
+    /**
+     * Removes all keys, keeping the memory for reuse.
+     */
+    void clear(void) {
+      Entry empty = {EMPTY, 0};
+      table.assign(table.size(), empty);
+      count = 0;
+    }
+
+    /**
+     * @return Amount of keys stored.
+     */
+    size_t size(void) const {
+      return count;
+    }
+};
+
+#endif // _IDMAP_H
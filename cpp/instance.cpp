@@ -0,0 +1,809 @@
+/***************************************************************************************************
+ *
+ * instance.cpp
+ * @author Ben Witzen
+ * @date Feb 27, 2017
+ *
+ * Part of my solution for Google's Hashcode 2017 challenge, submitted during the extended round.
+ *
+ * Function descriptions can be found in instance.h
+ *
+ **************************************************************************************************/
+
+#include "instance.h"
+#include "parser.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+// a merged request, with its sort key: score bits in the upper half, last line in the lower half
+struct SortedRequest {
+  uint64_t key;
+  uint32_t video;
+  size_t weight;
+
+  static bool before(const SortedRequest &a, const SortedRequest &b) {
+    return a.key > b.key;
+  }
+};
+
+// stable counting sort of line indices `in` into `out`, by a field in [0, range) of each line
+static void counting_sort(const std::vector<uint32_t> &in, std::vector<uint32_t> &out,
+                          size_t range, const std::vector<RequestLine> &lines,
+                          uint32_t RequestLine::*field) {
+  std::vector<size_t> offset(range + 1, 0);
+  for (size_t i = 0; i < in.size(); i++)
+    offset[lines[in[i]].*field + 1]++;
+  for (size_t k = 0; k < range; k++)
+    offset[k + 1] += offset[k];
+  for (size_t i = 0; i < in.size(); i++)
+    out[offset[lines[in[i]].*field]++] = in[i];
+}
+
+// the bytes of an array, as stored in a snapshot
+template <typename T>
+static Span<const char> bytes_of(Span<const T> array) {
+  return Span<const char>((const char *) array.begin(), array.size() * sizeof(T));
+}
+
+// makes a vector hold a copy of an array
+template <typename T>
+static void copy_into(std::vector<T> &to, Span<const T> from) {
+  to.assign(from.begin(), from.end());
+}
+
+// the arrays of Cache and Endpoint objects are mostly larger than a block, and get their own
+static const size_t ARENA_BLOCK_SIZE = 1 << 16;
+
+Instance::Instance(void) : arena(ARENA_BLOCK_SIZE) {
+  videos_amt = endpoints_amt = requests_amt = caches_amt = caches_size = input_size = 0;
+  snapshot = NULL;
+}
+
+Instance::~Instance(void) {
+  // the objects own vectors of their own; their memory and all requests go with the arena and pool
+  for (size_t i = 0; i < endpoints.size(); i++)
+    endpoints[i]->~Endpoint();
+  for (size_t i = 0; i < caches.size(); i++)
+    caches[i]->~Cache();
+  delete snapshot;
+}
+
+bool Instance::load(const char *path) {
+  if (Snapshot::is_snapshot(path))
+    return load_snapshot(path);
+
+  Parser in;
+  if (!in.open(path)) {
+    error = in.get_error();
+    return false;
+  }
+  input_size = in.get_size();
+
+  // read header; every field must fit in 32 bits, and every list it announces must fit in the
+  // input (an entry takes at least 2 bytes), before anything is allocated for it
+  size_t *fields[] = {&videos_amt, &endpoints_amt, &requests_amt, &caches_amt, &caches_size};
+  const char *names[] = {"videos", "endpoints", "requests", "caches", "cache size"};
+  for (size_t i = 0; i < sizeof fields / sizeof fields[0]; i++) {
+    if (!in.next(fields[i]) ||
+        (*fields[i] > UINT32_MAX && !in.reject(i < 4 ? std::string("too many ") + names[i] :
+                                                       std::string("cache size is too large"))) ||
+        (i < 3 && *fields[i] > input_size / 2 &&
+         !in.reject(std::string("more ") + names[i] + " than the input can hold"))) {
+      error = in.get_error();
+      return false;
+    }
+  }
+
+  // read video sizes
+  video_sizes.resize(videos_amt);
+  for (size_t i = 0; i < videos_amt; i++)
+    if (!in.next(&video_sizes[i]) || (video_sizes[i] == 0 && !in.reject("video has size 0"))) {
+      error = in.get_error();
+      return false;
+    }
+
+  // create caches, with their leftover capacities side by side
+  Cache *cache_array = arena.allocate_array<Cache>(caches_amt);
+  caches.reserve(caches_amt);
+  cache_remaining.resize(caches_amt);
+  for (size_t i = 0; i < caches_amt; i++) {
+    caches.push_back(new (cache_array + i) Cache(i, caches_size, &pool));
+    caches[i]->bind_remaining_space(&cache_remaining[i]);
+  }
+
+  // create endpoints and link endpoints <-> caches
+  Endpoint *endpoint_array = arena.allocate_array<Endpoint>(endpoints_amt);
+  endpoints.reserve(endpoints_amt);
+  datacenter_latency.resize(endpoints_amt);
+  link_offset.resize(endpoints_amt + 1);
+  link_offset[0] = 0;
+  for (size_t endp = 0; endp < endpoints_amt; endp++) {
+    size_t latency, links_amt;
+    if (!in.next(&latency) || (latency > UINT32_MAX && !in.reject("latency is too large")) ||
+        !in.next(&links_amt) ||
+        (links_amt > caches_amt && !in.reject("more links than there are caches"))) {
+      error = in.get_error();
+      return false;
+    }
+    datacenter_latency[endp] = latency;
+    size_t first = link_cache.size();
+    for (size_t i = 0; i < links_amt; i++) {
+      size_t id, latency;
+      if (!in.next(&id) || (id >= caches_amt &&
+                            !in.reject("cache " + std::to_string(id) + " does not exist")) ||
+          !in.next(&latency) || (latency > UINT32_MAX && !in.reject("latency is too large"))) {
+        error = in.get_error();
+        return false;
+      }
+      link_cache.push_back(id);
+      link_latency.push_back(latency);
+    }
+    link_offset[endp + 1] = link_cache.size();
+
+    // order the links from fastest to slowest cache, like Endpoint::add_cache does, so that they
+    // can be appended as they are instead of each looking for its place among those before it
+    sort_links(first, link_cache.size());
+
+    Endpoint *e = new (endpoint_array + endp) Endpoint(endp, latency, &pool);
+    endpoints.push_back(e);
+    e->reserve(links_amt, 0);
+    for (size_t i = first; i < link_cache.size(); i++)
+      e->append_cache(caches[link_cache[i]], link_latency[i]);
+  }
+
+  invert_links();
+
+  // collect all request descriptions; they are merged and sorted in bulk below
+  std::vector<RequestLine> lines(requests_amt);
+  for (size_t i = 0; i < requests_amt; i++) {
+    size_t request, endpoint, weight;
+    if (!in.next(&request) || (request >= videos_amt &&
+                               !in.reject("video " + std::to_string(request) +
+                                          " does not exist")) ||
+        !in.next(&endpoint) || (endpoint >= endpoints_amt &&
+                                !in.reject("endpoint " + std::to_string(endpoint) +
+                                           " does not exist")) ||
+        !in.next(&weight) || (weight > UINT32_MAX && !in.reject("weight is too large"))) {
+      error = in.get_error();
+      return false;
+    }
+    lines[i].video = request;
+    lines[i].endpoint = endpoint;
+    lines[i].weight = weight;
+  }
+
+  if (!in.finish()) {
+    error = in.get_error();
+    return false;
+  }
+
+  add_requests(lines);
+  invert_demands();
+  freeze();
+  return true;
+}
+
+void Instance::freeze(void) {
+  flat.video_sizes = Span<const size_t>(video_sizes.data(), video_sizes.size());
+  flat.datacenter_latency = Span<const uint32_t>(datacenter_latency.data(),
+                                                 datacenter_latency.size());
+  flat.link_offset = Span<const size_t>(link_offset.data(), link_offset.size());
+  flat.link_cache = Span<const uint32_t>(link_cache.data(), link_cache.size());
+  flat.link_latency = Span<const uint32_t>(link_latency.data(), link_latency.size());
+  flat.demand_offset = Span<const size_t>(demand_offset.data(), demand_offset.size());
+  flat.demand_video = Span<const uint32_t>(demand_video.data(), demand_video.size());
+  flat.demand_weight = Span<const size_t>(demand_weight.data(), demand_weight.size());
+  flat.cache_link_offset = Span<const size_t>(cache_link_offset.data(), cache_link_offset.size());
+  flat.cache_link_endpoint = Span<const uint32_t>(cache_link_endpoint.data(),
+                                                  cache_link_endpoint.size());
+  flat.cache_link_latency = Span<const uint32_t>(cache_link_latency.data(),
+                                                 cache_link_latency.size());
+  flat.video_demand_offset = Span<const size_t>(video_demand_offset.data(),
+                                                video_demand_offset.size());
+  flat.video_demand_number = Span<const uint32_t>(video_demand_number.data(),
+                                                  video_demand_number.size());
+  flat.video_demand_endpoint = Span<const uint32_t>(video_demand_endpoint.data(),
+                                                    video_demand_endpoint.size());
+  flat.video_demand_latency = Span<const uint32_t>(video_demand_latency.data(),
+                                                   video_demand_latency.size());
+  flat.video_demand_weight = Span<const size_t>(video_demand_weight.data(),
+                                                video_demand_weight.size());
+  flat.cache_demand_offset = Span<const size_t>(cache_demand_offset.data(),
+                                                cache_demand_offset.size());
+  flat.cache_demand_video = Span<const uint32_t>(cache_demand_video.data(),
+                                                 cache_demand_video.size());
+}
+
+// true if a CSR offset array has `rows` + 1 ascending entries, starting at 0 and ending at `total`
+static bool valid_offsets(Span<const size_t> offsets, size_t rows, size_t total) {
+  if (offsets.size() != rows + 1 || offsets[0] != 0 || offsets[rows] != total)
+    return false;
+  for (size_t i = 0; i < rows; i++)
+    if (offsets[i] > offsets[i + 1])
+      return false;
+  return true;
+}
+
+// true if all IDs in an array are below `bound`
+static bool valid_ids(Span<const uint32_t> ids, size_t bound) {
+  for (size_t i = 0; i < ids.size(); i++)
+    if (ids[i] >= bound)
+      return false;
+  return true;
+}
+
+bool Instance::load_snapshot(const char *path) {
+  snapshot = new Snapshot();
+  if (!snapshot->open(path)) {
+    error = snapshot->get_error();
+    return false;
+  }
+  input_size = snapshot->get_size();
+
+  const SnapshotHeader *header = snapshot->get_header();
+  videos_amt = header->videos;
+  endpoints_amt = header->endpoints;
+  requests_amt = header->requests;
+  caches_amt = header->caches;
+  caches_size = header->cache_size;
+  flat.video_sizes = snapshot->get_section<size_t>(VIDEO_SIZES);
+  flat.datacenter_latency = snapshot->get_section<uint32_t>(DATACENTER_LATENCY);
+  flat.link_offset = snapshot->get_section<size_t>(LINK_OFFSET);
+  flat.link_cache = snapshot->get_section<uint32_t>(LINK_CACHE);
+  flat.link_latency = snapshot->get_section<uint32_t>(LINK_LATENCY);
+  flat.demand_offset = snapshot->get_section<size_t>(DEMAND_OFFSET);
+  flat.demand_video = snapshot->get_section<uint32_t>(DEMAND_VIDEO);
+  flat.demand_weight = snapshot->get_section<size_t>(DEMAND_WEIGHT);
+  flat.cache_link_offset = snapshot->get_section<size_t>(CACHE_LINK_OFFSET);
+  flat.cache_link_endpoint = snapshot->get_section<uint32_t>(CACHE_LINK_ENDPOINT);
+  flat.cache_link_latency = snapshot->get_section<uint32_t>(CACHE_LINK_LATENCY);
+  flat.video_demand_offset = snapshot->get_section<size_t>(VIDEO_DEMAND_OFFSET);
+  flat.video_demand_number = snapshot->get_section<uint32_t>(VIDEO_DEMAND_NUMBER);
+  flat.video_demand_endpoint = snapshot->get_section<uint32_t>(VIDEO_DEMAND_ENDPOINT);
+  flat.video_demand_latency = snapshot->get_section<uint32_t>(VIDEO_DEMAND_LATENCY);
+  flat.video_demand_weight = snapshot->get_section<size_t>(VIDEO_DEMAND_WEIGHT);
+  flat.cache_demand_offset = snapshot->get_section<size_t>(CACHE_DEMAND_OFFSET);
+  flat.cache_demand_video = snapshot->get_section<uint32_t>(CACHE_DEMAND_VIDEO);
+
+  // loading leaves the checksum to ./convert --verify; these checks guard against a snapshot that
+  // was damaged or written wrongly, so that no ID can point outside an array
+  size_t links_amt = flat.link_cache.size(), demands_amt = flat.demand_video.size();
+  bool valid = videos_amt <= UINT32_MAX && endpoints_amt <= UINT32_MAX &&
+               flat.video_sizes.size() == videos_amt &&
+               flat.datacenter_latency.size() == endpoints_amt &&
+               valid_offsets(flat.link_offset, endpoints_amt, links_amt) &&
+               flat.link_latency.size() == links_amt && valid_ids(flat.link_cache, caches_amt) &&
+               valid_offsets(flat.demand_offset, endpoints_amt, demands_amt) &&
+               flat.demand_weight.size() == demands_amt &&
+               valid_ids(flat.demand_video, videos_amt) &&
+               valid_offsets(flat.cache_link_offset, caches_amt, links_amt) &&
+               flat.cache_link_endpoint.size() == links_amt &&
+               flat.cache_link_latency.size() == links_amt &&
+               valid_ids(flat.cache_link_endpoint, endpoints_amt) &&
+               valid_offsets(flat.video_demand_offset, videos_amt, demands_amt) &&
+               flat.video_demand_number.size() == demands_amt &&
+               flat.video_demand_endpoint.size() == demands_amt &&
+               flat.video_demand_latency.size() == demands_amt &&
+               flat.video_demand_weight.size() == demands_amt &&
+               valid_ids(flat.video_demand_number, demands_amt) &&
+               valid_ids(flat.video_demand_endpoint, endpoints_amt) &&
+               flat.cache_demand_offset.size() == caches_amt + 1 &&
+               valid_offsets(flat.cache_demand_offset, caches_amt,
+                             flat.cache_demand_offset[caches_amt]) &&
+               valid_ids(flat.cache_demand_video, videos_amt);
+  for (size_t i = 0; i < videos_amt && valid; i++)
+    valid = flat.video_sizes[i] > 0;
+  if (!valid) {
+    error = std::string(path) + ": snapshot does not describe a valid instance";
+    return false;
+  }
+
+  create_objects();
+  return true;
+}
+
+void Instance::create_objects(void) {
+  // same order as load() creates them in
+  Cache *cache_array = arena.allocate_array<Cache>(caches_amt);
+  caches.reserve(caches_amt);
+  cache_remaining.resize(caches_amt);
+  for (size_t i = 0; i < caches_amt; i++) {
+    caches.push_back(new (cache_array + i) Cache(i, caches_size, &pool));
+    caches[i]->bind_remaining_space(&cache_remaining[i]);
+  }
+  Endpoint *endpoint_array = arena.allocate_array<Endpoint>(endpoints_amt);
+  endpoints.reserve(endpoints_amt);
+  demand_index.resize(endpoints_amt);
+  for (size_t e = 0; e < endpoints_amt; e++) {
+    Endpoint *endpoint = new (endpoint_array + e) Endpoint(e, flat.datacenter_latency[e], &pool);
+    endpoints.push_back(endpoint);
+    endpoint->reserve(flat.link_offset[e + 1] - flat.link_offset[e], 0);
+    for (size_t i = flat.link_offset[e]; i < flat.link_offset[e + 1]; i++)
+      endpoint->append_cache(caches[flat.link_cache[i]], flat.link_latency[i]);
+  }
+  for (size_t e = 0; e < endpoints_amt; e++) {
+    endpoints[e]->reserve(0, flat.demand_offset[e + 1] - flat.demand_offset[e]);
+    demand_index[e].reserve(flat.demand_offset[e + 1] - flat.demand_offset[e]);
+    for (size_t d = flat.demand_offset[e]; d < flat.demand_offset[e + 1]; d++) {
+      uint32_t video = flat.demand_video[d];
+      endpoints[e]->append_request(pool.create(video, flat.video_sizes[video],
+                                               flat.demand_weight[d]));
+      demand_index[e].insert(video, d);
+    }
+  }
+}
+
+Instance *Instance::clone(void) {
+  Instance *copy = new Instance();
+  copy->videos_amt = videos_amt;
+  copy->endpoints_amt = endpoints_amt;
+  copy->requests_amt = requests_amt;
+  copy->caches_amt = caches_amt;
+  copy->caches_size = caches_size;
+  copy->input_size = input_size;
+
+  // the copy owns its flat model, wherever this one lies
+  copy_into(copy->video_sizes, flat.video_sizes);
+  copy_into(copy->datacenter_latency, flat.datacenter_latency);
+  copy_into(copy->link_offset, flat.link_offset);
+  copy_into(copy->link_cache, flat.link_cache);
+  copy_into(copy->link_latency, flat.link_latency);
+  copy_into(copy->demand_offset, flat.demand_offset);
+  copy_into(copy->demand_video, flat.demand_video);
+  copy_into(copy->demand_weight, flat.demand_weight);
+  copy_into(copy->cache_link_offset, flat.cache_link_offset);
+  copy_into(copy->cache_link_endpoint, flat.cache_link_endpoint);
+  copy_into(copy->cache_link_latency, flat.cache_link_latency);
+  copy_into(copy->video_demand_offset, flat.video_demand_offset);
+  copy_into(copy->video_demand_number, flat.video_demand_number);
+  copy_into(copy->video_demand_endpoint, flat.video_demand_endpoint);
+  copy_into(copy->video_demand_latency, flat.video_demand_latency);
+  copy_into(copy->video_demand_weight, flat.video_demand_weight);
+  copy_into(copy->cache_demand_offset, flat.cache_demand_offset);
+  copy_into(copy->cache_demand_video, flat.cache_demand_video);
+  copy->freeze();
+  copy->create_objects();
+  return copy;
+}
+
+bool Instance::save_snapshot(const char *path) {
+  SnapshotHeader header;
+  memset(&header, 0, sizeof header);
+  header.videos = videos_amt;
+  header.endpoints = endpoints_amt;
+  header.requests = requests_amt;
+  header.caches = caches_amt;
+  header.cache_size = caches_size;
+
+  Span<const char> sections[SNAPSHOT_SECTIONS];
+  sections[VIDEO_SIZES] = bytes_of(flat.video_sizes);
+  sections[DATACENTER_LATENCY] = bytes_of(flat.datacenter_latency);
+  sections[LINK_OFFSET] = bytes_of(flat.link_offset);
+  sections[LINK_CACHE] = bytes_of(flat.link_cache);
+  sections[LINK_LATENCY] = bytes_of(flat.link_latency);
+  sections[DEMAND_OFFSET] = bytes_of(flat.demand_offset);
+  sections[DEMAND_VIDEO] = bytes_of(flat.demand_video);
+  sections[DEMAND_WEIGHT] = bytes_of(flat.demand_weight);
+  sections[CACHE_LINK_OFFSET] = bytes_of(flat.cache_link_offset);
+  sections[CACHE_LINK_ENDPOINT] = bytes_of(flat.cache_link_endpoint);
+  sections[CACHE_LINK_LATENCY] = bytes_of(flat.cache_link_latency);
+  sections[VIDEO_DEMAND_OFFSET] = bytes_of(flat.video_demand_offset);
+  sections[VIDEO_DEMAND_NUMBER] = bytes_of(flat.video_demand_number);
+  sections[VIDEO_DEMAND_ENDPOINT] = bytes_of(flat.video_demand_endpoint);
+  sections[VIDEO_DEMAND_LATENCY] = bytes_of(flat.video_demand_latency);
+  sections[VIDEO_DEMAND_WEIGHT] = bytes_of(flat.video_demand_weight);
+  sections[CACHE_DEMAND_OFFSET] = bytes_of(flat.cache_demand_offset);
+  sections[CACHE_DEMAND_VIDEO] = bytes_of(flat.cache_demand_video);
+  return Snapshot::write(path, header, sections, &error);
+}
+
+void Instance::add_requests(const std::vector<RequestLine> &lines) {
+  // group the lines by (endpoint, video); both sorts are stable, so within a group the lines
+  // remain in the order they were read
+  std::vector<uint32_t> by_video(lines.size()), order(lines.size());
+  for (size_t i = 0; i < lines.size(); i++)
+    by_video[i] = i;
+  counting_sort(by_video, order, videos_amt, lines, &RequestLine::video);
+  counting_sort(order, by_video, endpoints_amt, lines, &RequestLine::endpoint);
+  order.swap(by_video);
+
+  // merge each group, then sort each endpoint's requests once. Endpoint::add_request keeps them
+  // ordered from highest to lowest score, placing a request before others with an equal score,
+  // and re-inserting a request whenever it is merged. The resulting order is therefore by score,
+  // then by the last line that mentions the video, both descending. The score is a positive
+  // float, so its bit pattern orders the same way as its value.
+  std::vector<SortedRequest> sorted;
+  demand_offset.assign(endpoints_amt + 1, 0);
+  demand_index.resize(endpoints_amt);
+  demand_video.reserve(lines.size());
+  demand_weight.reserve(lines.size());
+  size_t i = 0;
+  while (i < order.size()) {
+    uint32_t endpoint = lines[order[i]].endpoint;
+    sorted.clear();
+
+    for (; i < order.size() && lines[order[i]].endpoint == endpoint; i++) {
+      const RequestLine &line = lines[order[i]];
+      if (sorted.empty() || sorted.back().video != line.video) {
+        SortedRequest r = {0, line.video, 0};
+        sorted.push_back(r);
+      }
+      sorted.back().weight += line.weight;
+      sorted.back().key = order[i];
+    }
+
+    for (size_t r = 0; r < sorted.size(); r++) {
+      float score = sorted[r].weight / (float) video_sizes[sorted[r].video];
+      uint32_t bits;
+      memcpy(&bits, &score, sizeof bits);
+      sorted[r].key |= (uint64_t) bits << 32;
+    }
+    std::sort(sorted.begin(), sorted.end(), SortedRequest::before);
+    endpoints[endpoint]->reserve(0, sorted.size());
+    demand_index[endpoint].reserve(sorted.size());
+
+    for (size_t r = 0; r < sorted.size(); r++) {
+      endpoints[endpoint]->append_request(pool.create(sorted[r].video,
+                                                      video_sizes[sorted[r].video],
+                                                      sorted[r].weight));
+      demand_index[endpoint].insert(sorted[r].video, demand_video.size());
+      demand_video.push_back(sorted[r].video);
+      demand_weight.push_back(sorted[r].weight);
+    }
+    demand_offset[endpoint + 1] = sorted.size();
+  }
+
+  // endpoints were visited in order, so the offsets follow from the amounts
+  for (size_t e = 0; e < endpoints_amt; e++)
+    demand_offset[e + 1] += demand_offset[e];
+}
+
+void Instance::sort_links(size_t first, size_t last) {
+  for (size_t i = first + 1; i < last; i++) {
+    uint32_t cache = link_cache[i], latency = link_latency[i];
+    size_t slot = i;
+    for (; slot > first && link_latency[slot - 1] > latency; slot--) {
+      link_cache[slot] = link_cache[slot - 1];
+      link_latency[slot] = link_latency[slot - 1];
+    }
+    link_cache[slot] = cache;
+    link_latency[slot] = latency;
+  }
+}
+
+bool Instance::read_solution(const char *path, std::vector<std::vector<uint32_t> > *contents) {
+  Parser in;
+  if (!in.open(path)) {
+    error = in.get_error();
+    return false;
+  }
+
+  contents->assign(caches_amt, std::vector<uint32_t>());
+  std::vector<bool> listed(caches_amt, false);
+  IdMap stored;
+
+  size_t lines_amt;
+  if (!in.next(&lines_amt) || (lines_amt > caches_amt &&
+                               !in.reject("more cache descriptions than caches"))) {
+    error = in.get_error();
+    return false;
+  }
+
+  for (size_t i = 0; i < lines_amt; i++) {
+    size_t cache;
+    if (!in.next(&cache) || (cache >= caches_amt &&
+                             !in.reject("cache " + std::to_string(cache) + " does not exist")) ||
+        (listed[cache] && !in.reject("cache " + std::to_string(cache) + " is listed twice"))) {
+      error = in.get_error();
+      return false;
+    }
+    listed[cache] = true;
+
+    std::vector<uint32_t> &videos = (*contents)[cache];
+    size_t used = 0;
+    stored.clear();
+    while (!in.at_end_of_line()) {
+      size_t video;
+      if (!in.next(&video) || (video >= videos_amt &&
+                               !in.reject("video " + std::to_string(video) + " does not exist")) ||
+          (stored.find(video) != IdMap::EMPTY &&
+           !in.reject("video " + std::to_string(video) + " is listed twice")) ||
+          (used + flat.video_sizes[video] > caches_size &&
+           !in.reject("video " + std::to_string(video) + " exceeds the capacity of cache " +
+                      std::to_string(cache)))) {
+        error = in.get_error();
+        return false;
+      }
+      stored.insert(video, 0);
+      used += flat.video_sizes[video];
+      videos.push_back(video);
+    }
+  }
+
+  if (!in.finish()) {
+    error = in.get_error();
+    return false;
+  }
+  return true;
+}
+
+bool Instance::load_solution(const char *path) {
+  std::vector<std::vector<uint32_t> > contents;
+  if (!read_solution(path, &contents))
+    return false;
+
+  // the videos fit in empty caches, but not necessarily next to videos stored before
+  for (size_t c = 0; c < contents.size(); c++)
+    for (size_t i = 0; i < contents[c].size(); i++)
+      if (!place_video(c, contents[c][i])) {
+        error = std::string(path) + ": video " + std::to_string(contents[c][i]) +
+                " does not fit in cache " + std::to_string(c) + " next to its current videos";
+        return false;
+      }
+  return true;
+}
+
+bool Instance::place_video(size_t cache, size_t video) {
+  Cache *c = caches[cache];
+  if (!c->has_video(video) && c->get_remaining_space() < flat.video_sizes[video])
+    return false;
+
+  Span<const uint32_t> connected = get_cache_endpoints(cache);
+  bool stored = c->has_video(video);
+  for (size_t i = 0; i < connected.size(); i++) {
+    Request *request = endpoints[connected[i]]->find_request(video);
+    if (request != NULL)
+      stored |= c->push_video(endpoints[connected[i]], request);
+  }
+  if (!stored)
+    c->push_video(NULL, pool.create(video, flat.video_sizes[video], 0));
+  return true;
+}
+
+RequestPool *Instance::get_pool(void) {
+  return &pool;
+}
+
+void Instance::add_listener(CacheListener *listener) {
+  for (size_t i = 0; i < caches_amt; i++)
+    caches[i]->add_listener(listener);
+}
+
+void Instance::remove_listener(CacheListener *listener) {
+  for (size_t i = 0; i < caches_amt; i++)
+    caches[i]->remove_listener(listener);
+}
+
+const char *Instance::get_error(void) {
+  return error.c_str();
+}
+
+size_t Instance::get_input_size(void) {
+  return input_size;
+}
+
+size_t Instance::get_videos_amount(void) {
+  return videos_amt;
+}
+
+size_t Instance::get_endpoints_amount(void) {
+  return endpoints_amt;
+}
+
+size_t Instance::get_requests_amount(void) {
+  return requests_amt;
+}
+
+size_t Instance::get_caches_amount(void) {
+  return caches_amt;
+}
+
+size_t Instance::get_cache_size(void) {
+  return caches_size;
+}
+
+size_t Instance::get_video_size(size_t id) {
+  return flat.video_sizes[id];
+}
+
+Cache *Instance::get_cache(size_t id) {
+  return caches[id];
+}
+
+Endpoint *Instance::get_endpoint(size_t id) {
+  return endpoints[id];
+}
+
+void Instance::invert_links(void) {
+  cache_link_offset.assign(caches_amt + 1, 0);
+  for (size_t i = 0; i < link_cache.size(); i++)
+    cache_link_offset[link_cache[i] + 1]++;
+  for (size_t c = 0; c < caches_amt; c++)
+    cache_link_offset[c + 1] += cache_link_offset[c];
+
+  cache_link_endpoint.resize(link_cache.size());
+  cache_link_latency.resize(link_cache.size());
+  std::vector<size_t> fill(cache_link_offset.begin(), cache_link_offset.end() - 1);
+  for (size_t e = 0; e < endpoints_amt; e++)
+    for (size_t i = link_offset[e]; i < link_offset[e + 1]; i++) {
+      size_t slot = fill[link_cache[i]]++;
+      cache_link_endpoint[slot] = e;
+      cache_link_latency[slot] = link_latency[i];
+    }
+}
+
+void Instance::invert_demands(void) {
+  // endpoints are visited in order, so each video lists its endpoints in ascending order
+  size_t demands_amt = demand_video.size();
+  video_demand_offset.assign(videos_amt + 1, 0);
+  for (size_t d = 0; d < demands_amt; d++)
+    video_demand_offset[demand_video[d] + 1]++;
+  for (size_t v = 0; v < videos_amt; v++)
+    video_demand_offset[v + 1] += video_demand_offset[v];
+
+  video_demand_number.resize(demands_amt);
+  video_demand_endpoint.resize(demands_amt);
+  video_demand_latency.resize(demands_amt);
+  video_demand_weight.resize(demands_amt);
+  std::vector<size_t> fill(video_demand_offset.begin(), video_demand_offset.end() - 1);
+  for (size_t e = 0; e < endpoints_amt; e++)
+    for (size_t d = demand_offset[e]; d < demand_offset[e + 1]; d++) {
+      size_t slot = fill[demand_video[d]]++;
+      video_demand_number[slot] = d;
+      video_demand_endpoint[slot] = e;
+      video_demand_latency[slot] = datacenter_latency[e];
+      video_demand_weight[slot] = demand_weight[d];
+    }
+
+  // the caches of a video are those linked to the endpoints that request it. Where endpoints link
+  // to many of the caches, as in kittens, ORing a bitmask of the caches of each endpoint is
+  // fastest, but the masks take endpoints * caches / 64 words, so they are only built if that is
+  // no more than the amount of links. Otherwise each cache is stamped with the last video that
+  // reached it, so that it is listed once per video, at the cost of the links of the endpoints
+  // that request the video; once all caches are reached, the remaining endpoints can add none
+  size_t words = (caches_amt + 63) / 64;
+  bool by_mask = endpoints_amt * words <= link_cache.size();
+  std::vector<uint64_t> masks(by_mask ? endpoints_amt * words : 0), mask(by_mask ? words : 0);
+  for (size_t e = 0; e < endpoints_amt && by_mask; e++)
+    for (size_t l = link_offset[e]; l < link_offset[e + 1]; l++)
+      masks[e * words + link_cache[l] / 64] |= (uint64_t) 1 << (link_cache[l] % 64);
+  std::vector<size_t> stamp(by_mask ? 0 : caches_amt);
+
+  // videos are visited in order, so each cache lists its videos in ascending order. The first
+  // round counts the videos of each cache, the second one fills them in
+  cache_demand_offset.assign(caches_amt + 1, 0);
+  for (int round = 0; round < 2; round++) {
+    std::fill(stamp.begin(), stamp.end(), 0);
+    for (size_t v = 0; v < videos_amt; v++) {
+      auto take = [&](size_t c) {
+        if (round == 0)
+          cache_demand_offset[c + 1]++;
+        else
+          cache_demand_video[fill[c]++] = v;
+      };
+      if (by_mask) {
+        std::fill(mask.begin(), mask.end(), 0);
+        for (size_t i = video_demand_offset[v]; i < video_demand_offset[v + 1]; i++) {
+          const uint64_t *from = &masks[video_demand_endpoint[i] * words];
+          for (size_t w = 0; w < words; w++)
+            mask[w] |= from[w];
+        }
+        for (size_t w = 0; w < words; w++)
+          for (uint64_t bits = mask[w]; bits != 0; bits &= bits - 1)
+            take(w * 64 + __builtin_ctzll(bits));
+      }
+      else {
+        size_t reached = 0;
+        for (size_t i = video_demand_offset[v];
+             i < video_demand_offset[v + 1] && reached < caches_amt; i++) {
+          size_t e = video_demand_endpoint[i];
+          for (size_t l = link_offset[e]; l < link_offset[e + 1]; l++)
+            if (stamp[link_cache[l]] != v + 1) {
+              stamp[link_cache[l]] = v + 1;
+              take(link_cache[l]);
+              reached++;
+            }
+        }
+      }
+    }
+
+    if (round == 0) {
+      for (size_t c = 0; c < caches_amt; c++)
+        cache_demand_offset[c + 1] += cache_demand_offset[c];
+      cache_demand_video.resize(cache_demand_offset[caches_amt]);
+      fill.assign(cache_demand_offset.begin(), cache_demand_offset.end() - 1);
+    }
+  }
+}
+
+uint32_t Instance::get_datacenter_latency(size_t endpoint) {
+  return flat.datacenter_latency[endpoint];
+}
+
+Span<const uint32_t> Instance::get_link_caches(size_t endpoint) {
+  return Span<const uint32_t>(flat.link_cache.begin() + flat.link_offset[endpoint],
+                              flat.link_offset[endpoint + 1] - flat.link_offset[endpoint]);
+}
+
+Span<const uint32_t> Instance::get_link_latencies(size_t endpoint) {
+  return Span<const uint32_t>(flat.link_latency.begin() + flat.link_offset[endpoint],
+                              flat.link_offset[endpoint + 1] - flat.link_offset[endpoint]);
+}
+
+Span<const uint32_t> Instance::get_demand_videos(size_t endpoint) {
+  return Span<const uint32_t>(flat.demand_video.begin() + flat.demand_offset[endpoint],
+                              flat.demand_offset[endpoint + 1] - flat.demand_offset[endpoint]);
+}
+
+Span<const size_t> Instance::get_demand_weights(size_t endpoint) {
+  return Span<const size_t>(flat.demand_weight.begin() + flat.demand_offset[endpoint],
+                            flat.demand_offset[endpoint + 1] - flat.demand_offset[endpoint]);
+}
+
+Span<const uint32_t> Instance::get_cache_endpoints(size_t cache) {
+  return Span<const uint32_t>(flat.cache_link_endpoint.begin() + flat.cache_link_offset[cache],
+                              flat.cache_link_offset[cache + 1] - flat.cache_link_offset[cache]);
+}
+
+Span<const uint32_t> Instance::get_cache_latencies(size_t cache) {
+  return Span<const uint32_t>(flat.cache_link_latency.begin() + flat.cache_link_offset[cache],
+                              flat.cache_link_offset[cache + 1] - flat.cache_link_offset[cache]);
+}
+
+Span<const uint32_t> Instance::get_video_endpoints(size_t video) {
+  size_t first = flat.video_demand_offset[video];
+  return Span<const uint32_t>(flat.video_demand_endpoint.begin() + first,
+                              flat.video_demand_offset[video + 1] - first);
+}
+
+Span<const uint32_t> Instance::get_video_demands(size_t video) {
+  size_t first = flat.video_demand_offset[video];
+  return Span<const uint32_t>(flat.video_demand_number.begin() + first,
+                              flat.video_demand_offset[video + 1] - first);
+}
+
+Span<const uint32_t> Instance::get_video_latencies(size_t video) {
+  size_t first = flat.video_demand_offset[video];
+  return Span<const uint32_t>(flat.video_demand_latency.begin() + first,
+                              flat.video_demand_offset[video + 1] - first);
+}
+
+Span<const size_t> Instance::get_video_weights(size_t video) {
+  size_t first = flat.video_demand_offset[video];
+  return Span<const size_t>(flat.video_demand_weight.begin() + first,
+                            flat.video_demand_offset[video + 1] - first);
+}
+
+Span<const uint32_t> Instance::get_cache_videos(size_t cache) {
+  size_t first = flat.cache_demand_offset[cache];
+  return Span<const uint32_t>(flat.cache_demand_video.begin() + first,
+                              flat.cache_demand_offset[cache + 1] - first);
+}
+
+size_t Instance::get_demands_amount(void) {
+  return flat.demand_video.size();
+}
+
+size_t Instance::get_first_demand(size_t endpoint) {
+  return flat.demand_offset[endpoint];
+}
+
+uint32_t Instance::find_demand(size_t endpoint, size_t video) {
+  return demand_index[endpoint].find(video);
+}
+
+size_t Instance::get_demand_weight(size_t demand) {
+  return flat.demand_weight[demand];
+}
+
+Span<const size_t> Instance::get_remaining_spaces(void) {
+  return Span<const size_t>(cache_remaining.data(), caches_amt);
+}
+
+void Instance::print_raw(FILE *f) {
+  fprintf(f, "%lu\n", caches_amt);
+  for (size_t i = 0; i < caches_amt; i++)
+    caches[i]->print_raw(f);
+}
@@ -0,0 +1,414 @@
+/***************************************************************************************************
+ *
+ * instance.h
+ * @author Ben Witzen
+ * @date Feb 27, 2017
+ *
+ * Part of my solution for Google's Hashcode 2017 challenge, submitted during the extended round.
+ *
+ * Defines the Instance, which owns everything that is read from an input file: the video sizes,
+ * the Cache objects and the Endpoint objects. All of these live in contiguous heap arrays that are
+ * sized once from the header of the input file, so arbitrarily large inputs can be loaded without
+ * exhausting the stack and without any reallocation while loading. The Cache and Endpoint objects
+ * are laid out in one array each, in an Arena, and the Request objects come from a RequestPool
+ * (see arena.h), so that neither creating nor destroying an instance allocates or frees memory
+ * object by object.
+ *
+ * Besides the object model used by compute() functions, an Instance keeps a flat model of the same
+ * data: compressed sparse row (CSR) arrays that list, for every endpoint, its (cache, latency)
+ * links and its (video, weight) requests, the same links seen from each cache, and one contiguous
+ * array with the leftover capacity of every cache. Requests are numbered across all endpoints, and
+ * can be looked up by (endpoint, video) in constant time. The requests are also inverted: for every
+ * video, the endpoints that request it with their weight and datacenter latency, and for every
+ * cache, the videos requested by any endpoint connected to it. Algorithms that sweep over all
+ * endpoints, caches or videos can use these arrays instead of chasing pointers from object to
+ * object. The CSR arrays describe the instance as it was loaded; only the leftover capacities
+ * change during a computation, as the Cache objects write them.
+ *
+ * An Instance can also be loaded from a snapshot (see snapshot.h), which holds the CSR arrays as
+ * they are after loading an input file. The arrays are then used where they lie in the mapped
+ * file, and only the objects are created. In the same way, an Instance can be cloned into a fresh
+ * one, as it was right after loading, without reading the input again.
+ *
+ **************************************************************************************************/
+
+#ifndef _INSTANCE_H
+#define _INSTANCE_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "arena.h"
+#include "idmap.h"
+#include "snapshot.h"
+#include "span.h"
+#include "youtube.h"
+
+/**
+ * A request description as read from the input file.
+ */
+struct RequestLine {
+  uint32_t video, endpoint, weight;
+};
+
+/**
+ * Instance class.
+ */
+class Instance {
+  private:
+    size_t videos_amt, endpoints_amt, requests_amt, caches_amt, caches_size, input_size;
+    std::vector<size_t> video_sizes;
+    Arena arena;
+    RequestPool pool;
+    std::vector<Cache *> caches;
+    std::vector<Endpoint *> endpoints;
+    std::string error;
+
+    // flat model, read through these spans; they point into the vectors below when an input file
+    // was loaded, or into the mapped snapshot
+    struct {
+      Span<const size_t> video_sizes, link_offset, demand_offset, demand_weight, cache_link_offset;
+      Span<const uint32_t> datacenter_latency, link_cache, link_latency, demand_video;
+      Span<const uint32_t> cache_link_endpoint, cache_link_latency;
+      Span<const size_t> video_demand_offset, video_demand_weight, cache_demand_offset;
+      Span<const uint32_t> video_demand_number, video_demand_endpoint, video_demand_latency;
+      Span<const uint32_t> cache_demand_video;
+    } flat;
+    Snapshot *snapshot;
+    std::vector<uint32_t> datacenter_latency;
+    std::vector<size_t> link_offset, demand_offset;
+    std::vector<uint32_t> link_cache, link_latency, demand_video;
+    std::vector<size_t> demand_weight;
+    std::vector<IdMap> demand_index;
+    std::vector<size_t> cache_link_offset;
+    std::vector<uint32_t> cache_link_endpoint, cache_link_latency;
+    std::vector<size_t> video_demand_offset, video_demand_weight, cache_demand_offset;
+    std::vector<uint32_t> video_demand_number, video_demand_endpoint, video_demand_latency;
+    std::vector<uint32_t> cache_demand_video;
+    std::vector<size_t> cache_remaining;
+
+    // instances own their objects and cannot be copied
+    Instance(const Instance &);
+    Instance &operator=(const Instance &);
+
+    /**
+     * Merges request descriptions that name the same (endpoint, video) pair, and hands each end-
+     * point its requests in the same order that calling Endpoint::add_request() line by line would
+     * produce. Runs in O(lines log lines) rather than O(lines^2) per endpoint.
+     * @arg lines All request descriptions, in the order they appear in the input file.
+     */
+    void add_requests(const std::vector<RequestLine> &lines);
+
+    /**
+     * Orders a range of links from fastest to slowest cache. Links with equal latency keep their
+     * order, matching Endpoint::add_cache().
+     * @arg first Position of the first link.
+     * @arg last Position past the last link.
+     */
+    void sort_links(size_t first, size_t last);
+
+    /**
+     * Builds the links seen from each cache out of the links of each endpoint.
+     */
+    void invert_links(void);
+
+    /**
+     * Builds the requests seen from each video out of the requests of each endpoint, then the
+     * videos requested around each cache out of those and the links.
+     */
+    void invert_demands(void);
+
+    /**
+     * Points the flat model at the vectors it was built in.
+     */
+    void freeze(void);
+
+    /**
+     * Maps a snapshot, checks that its arrays describe a valid instance, and creates all Cache
+     * and Endpoint objects.
+     * @arg path Path to the snapshot.
+     * @return true on success, false on failure (see get_error()).
+     */
+    bool load_snapshot(const char *path);
+
+    /**
+     * Creates all Cache and Endpoint objects, and the requests of the endpoints, from the flat
+     * model.
+     */
+    void create_objects(void);
+
+  public:
+    /**
+     * Constructor. Creates an empty instance; use load() to fill it.
+     */
+    Instance(void);
+
+    /**
+     * Destructor.
+     * All Cache, Endpoint and Request objects owned by this Instance are also destroyed.
+     */
+    ~Instance(void);
+
+    /**
+     * Reads an input file or a snapshot and creates all Cache and Endpoint objects it describes.
+     * @arg path Path to the input file.
+     * @return true on success, false on failure (see get_error()).
+     */
+    bool load(const char *path);
+
+    /**
+     * Writes a snapshot of the instance as it was loaded, so that it can be loaded again without
+     * parsing.
+     * @arg path Path to the snapshot to write.
+     * @return true on success, false on failure (see get_error()).
+     */
+    bool save_snapshot(const char *path);
+
+    /**
+     * Creates a new instance as this one was loaded: the same flat model, with fresh Cache and
+     * Endpoint objects that store no videos yet. The copy owns its flat model, so it outlives this
+     * instance and any snapshot it was loaded from.
+     * @return The new instance, to be deleted by the caller.
+     */
+    Instance *clone(void);
+
+    /**
+     * Reads a solution file in the submission format and checks it against this instance: cache
+     * and video IDs must exist, no cache or video may be listed twice, and the videos listed for a
+     * cache must fit in it.
+     * @arg path Path to the solution file.
+     * @arg contents Gets overwritten with the video IDs listed for each cache, indexed by cache ID.
+     * @return true on success, false on failure (see get_error()).
+     */
+    bool read_solution(const char *path, std::vector<std::vector<uint32_t> > *contents);
+
+    /**
+     * Reads a solution file (see read_solution()) and stores its videos in the caches with
+     * place_video(), so that a computation can continue from it.
+     * @arg path Path to the solution file.
+     * @return true on success, false on failure (see get_error()).
+     */
+    bool load_solution(const char *path);
+
+    /**
+     * Stores a video in a cache on behalf of all endpoints connected to it: every request for the
+     * video lined up in those endpoints is pushed into the cache (and thereby merged). If none of
+     * them requests the video, it is stored without any weight.
+     * @arg cache Cache ID.
+     * @arg video Video ID.
+     * @return true on success, false if the video does not fit in the cache.
+     */
+    bool place_video(size_t cache, size_t video);
+
+    /**
+     * @return The pool that creates the Request objects of this instance. Requests that are pushed
+     *         into its caches without an endpoint must come from it.
+     */
+    RequestPool *get_pool(void);
+
+    /**
+     * Registers a listener with every cache of this instance.
+     * @arg listener Reference to the listener.
+     */
+    void add_listener(CacheListener *listener);
+
+    /**
+     * Unregisters a listener from every cache of this instance.
+     * @arg listener Reference to the listener.
+     */
+    void remove_listener(CacheListener *listener);
+
+    /**
+     * @return Description of the last error.
+     */
+    const char *get_error(void);
+
+    /**
+     * @return Size in bytes of the input file or snapshot that was loaded.
+     */
+    size_t get_input_size(void);
+
+    /**
+     * @return Amount of videos.
+     */
+    size_t get_videos_amount(void);
+
+    /**
+     * @return Amount of endpoints.
+     */
+    size_t get_endpoints_amount(void);
+
+    /**
+     * @return Amount of request descriptions in the input file.
+     */
+    size_t get_requests_amount(void);
+
+    /**
+     * @return Amount of caches.
+     */
+    size_t get_caches_amount(void);
+
+    /**
+     * @return Capacity of each cache in MB.
+     */
+    size_t get_cache_size(void);
+
+    /**
+     * @arg id Video ID.
+     * @return Size of the video in MB.
+     */
+    size_t get_video_size(size_t id);
+
+    /**
+     * @arg id Cache ID.
+     * @return Reference to the cache.
+     */
+    Cache *get_cache(size_t id);
+
+    /**
+     * @arg id Endpoint ID.
+     * @return Reference to the endpoint.
+     */
+    Endpoint *get_endpoint(size_t id);
+
+    /**
+     * @arg endpoint Endpoint ID.
+     * @return Latency in ms from the endpoint to the datacenter.
+     */
+    uint32_t get_datacenter_latency(size_t endpoint);
+
+    /**
+     * @arg endpoint Endpoint ID.
+     * @return IDs of the caches connected to the endpoint, from fastest to slowest cache.
+     */
+    Span<const uint32_t> get_link_caches(size_t endpoint);
+
+    /**
+     * @arg endpoint Endpoint ID.
+     * @return Latencies in ms to the caches connected to the endpoint, in the order of
+     *         get_link_caches().
+     */
+    Span<const uint32_t> get_link_latencies(size_t endpoint);
+
+    /**
+     * @arg endpoint Endpoint ID.
+     * @return IDs of the videos requested by the endpoint, from highest to lowest score.
+     */
+    Span<const uint32_t> get_demand_videos(size_t endpoint);
+
+    /**
+     * @arg endpoint Endpoint ID.
+     * @return Merged weights of the requests, in the order of get_demand_videos().
+     */
+    Span<const size_t> get_demand_weights(size_t endpoint);
+
+    /**
+     * @arg cache Cache ID.
+     * @return IDs of the endpoints connected to the cache, in ascending order.
+     */
+    Span<const uint32_t> get_cache_endpoints(size_t cache);
+
+    /**
+     * @arg cache Cache ID.
+     * @return Latencies in ms from the endpoints to the cache, in the order of
+     *         get_cache_endpoints().
+     */
+    Span<const uint32_t> get_cache_latencies(size_t cache);
+
+    /**
+     * @arg video Video ID.
+     * @return IDs of the endpoints that request the video, in ascending order.
+     */
+    Span<const uint32_t> get_video_endpoints(size_t video);
+
+    /**
+     * @arg video Video ID.
+     * @return Numbers of the requests for the video (see find_demand()), in the order of
+     *         get_video_endpoints().
+     */
+    Span<const uint32_t> get_video_demands(size_t video);
+
+    /**
+     * @arg video Video ID.
+     * @return Latencies in ms from the requesting endpoints to the datacenter, in the order of
+     *         get_video_endpoints().
+     */
+    Span<const uint32_t> get_video_latencies(size_t video);
+
+    /**
+     * @arg video Video ID.
+     * @return Merged weights of the requests for the video, in the order of get_video_endpoints().
+     */
+    Span<const size_t> get_video_weights(size_t video);
+
+    /**
+     * @arg cache Cache ID.
+     * @return IDs of the videos requested by any endpoint connected to the cache, in ascending
+     *         order and each once.
+     */
+    Span<const uint32_t> get_cache_videos(size_t cache);
+
+    /**
+     * @return Amount of distinct (endpoint, video) requests, after merging.
+     */
+    size_t get_demands_amount(void);
+
+    /**
+     * @arg endpoint Endpoint ID.
+     * @return Number of the first request of the endpoint. The requests of an endpoint are
+     *         numbered consecutively, in the order of get_demand_videos().
+     */
+    size_t get_first_demand(size_t endpoint);
+
+    /**
+     * @arg endpoint Endpoint ID.
+     * @arg video Video ID.
+     * @return Number of the request the endpoint makes for the video, or IdMap::EMPTY if none.
+     */
+    uint32_t find_demand(size_t endpoint, size_t video);
+
+    /**
+     * Finds the latency an endpoint gets a video with from the fastest of its caches that store
+     * the video, or from the datacenter if none of them does; this is where the endpoint falls
+     * back to when the video leaves the cache it came from.
+     * @arg endpoint Endpoint ID.
+     * @arg video Video ID.
+     * @arg has Predicate has(cache, video) telling whether a cache stores a video, so that the
+     *          caller can ask about contents of its own, or leave a cache out.
+     * @return Latency in ms.
+     */
+    template <typename Has>
+    uint32_t find_fallback_latency(size_t endpoint, size_t video, const Has &has) {
+      uint32_t latency = get_datacenter_latency(endpoint);
+      Span<const uint32_t> caches = get_link_caches(endpoint);
+      Span<const uint32_t> latencies = get_link_latencies(endpoint);
+      for (size_t c = 0; c < caches.size() && latencies[c] < latency; c++)
+        if (has(caches[c], video))
+          return latencies[c];
+      return latency;
+    }
+
+    /**
+     * @arg demand Number of a request, as returned by find_demand().
+     * @return Merged weight of the request.
+     */
+    size_t get_demand_weight(size_t demand);
+
+    /**
+     * @return Leftover capacity in MB of every cache, indexed by cache ID. Kept up to date by the
+     *         Cache objects.
+     */
+    Span<const size_t> get_remaining_spaces(void);
+
+    /**
+     * Prints the contents of all caches, following the submission format as was provided by
+     * Google.
+     * @arg f C-style FILE pointer to write into.
+     */
+    void print_raw(FILE *f);
+};
+
+#endif // _INSTANCE_H
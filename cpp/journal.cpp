@@ -0,0 +1,102 @@
+/***************************************************************************************************
+ *
+ * journal.cpp
+ * @author Ben Witzen
+ * @date Feb 27, 2017
+ *
+ * Part of my solution for Google's Hashcode 2017 challenge, submitted during the extended round.
+ *
+ * Function descriptions can be found in journal.h
+ *
+ **************************************************************************************************/
+
+#include "journal.h"
+
+Journal::Journal(Instance *instance) {
+  this->instance = instance;
+  undoing = false;
+  instance->add_listener(this);
+}
+
+Journal::~Journal(void) {
+  instance->remove_listener(this);
+}
+
+size_t Journal::get_mark(void) {
+  return entries.size();
+}
+
+void Journal::undo(const Entry &entry) {
+  if (entry.kind == Entry::ADDED)
+    entry.cache->remove_video(entry.video);
+  else if (entry.kind == Entry::MERGED)
+    entry.cache->return_request(entry.video);
+  else if (entry.kind == Entry::RETURNED) {
+    if (entry.endpoint != NULL)
+      entry.cache->push_video(entry.endpoint, entry.endpoint->find_request(entry.video));
+  }
+
+  // put a removed video back, pushing the returned requests in their original order; weight that
+  // was pushed without an endpoint is gone, only the video itself comes back
+  else {
+    for (size_t i = entry.first; i < entry.first + entry.count; i++) {
+      Endpoint *endpoint = returned[i];
+      if (endpoint != NULL)
+        entry.cache->push_video(endpoint, endpoint->find_request(entry.video));
+      else if (i == entry.first) {
+        size_t size = instance->get_video_size(entry.video);
+        entry.cache->push_video(NULL, instance->get_pool()->create(entry.video, size, 0));
+      }
+    }
+  }
+}
+
+void Journal::rollback(size_t mark) {
+  undoing = true;
+  while (entries.size() > mark) {
+    undo(entries.back());
+    if (entries.back().kind == Entry::REMOVED)
+      returned.resize(entries.back().first);
+    entries.pop_back();
+  }
+  undoing = false;
+}
+
+void Journal::commit(void) {
+  entries.clear();
+  returned.clear();
+}
+
+size_t Journal::get_size(void) {
+  return entries.size();
+}
+
+void Journal::video_added(Cache *cache, Request *video) {
+  if (undoing)
+    return;
+  Entry entry = {Entry::ADDED, cache, (uint32_t) video->get_video_id(), 0, 0, NULL};
+  entries.push_back(entry);
+}
+
+void Journal::video_merged(Cache *cache, Request *video) {
+  if (undoing)
+    return;
+  Entry entry = {Entry::MERGED, cache, (uint32_t) video->get_video_id(), 0, 0, NULL};
+  entries.push_back(entry);
+}
+
+void Journal::video_removed(Cache *cache, size_t video_id, Span<Endpoint *const> returned) {
+  if (undoing)
+    return;
+  Entry entry = {Entry::REMOVED, cache, (uint32_t) video_id, (uint32_t) this->returned.size(),
+                 (uint32_t) returned.size(), NULL};
+  this->returned.insert(this->returned.end(), returned.begin(), returned.end());
+  entries.push_back(entry);
+}
+
+void Journal::request_returned(Cache *cache, Endpoint *endpoint, size_t video_id) {
+  if (undoing)
+    return;
+  Entry entry = {Entry::RETURNED, cache, (uint32_t) video_id, 0, 0, endpoint};
+  entries.push_back(entry);
+}
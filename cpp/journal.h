@@ -0,0 +1,111 @@
+/***************************************************************************************************
+ *
+ * journal.h
+ * @author Ben Witzen
+ * @date Feb 27, 2017
+ *
+ * Part of my solution for Google's Hashcode 2017 challenge, submitted during the extended round.
+ *
+ * Defines the Journal, which records every change made to the caches of an Instance so that the
+ * changes can be undone. A local search tries a move (a few pushes, removals and returned
+ * requests), looks at the score, and either keeps the move with commit() or undoes it with
+ * rollback(); undoing costs as much as the move did, not as much as copying the solution.
+ *
+ * The Journal registers itself with every Cache. Changes are undone through the caches themselves,
+ * in reverse order, so every other listener (the Scorer, a GainEngine) follows the rollback too.
+ * A rollback restores which videos the caches store and which requests the endpoints have lined
+ * up, with their weights and positions; a video that was removed and put back ends up last in its
+ * cache. Like the GainEngine, the Journal is meant for single-threaded use. `make check` puts
+ * rollbacks to the test with random moves on every input (see check.cpp).
+ *
+ **************************************************************************************************/
+
+#ifndef _JOURNAL_H
+#define _JOURNAL_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+#include "instance.h"
+#include "youtube.h"
+
+/**
+ * Journal class.
+ */
+class Journal : public CacheListener {
+  private:
+    // a change to one cache; removals keep the endpoints they returned requests to in `returned`
+    struct Entry {
+      enum {ADDED, MERGED, REMOVED, RETURNED} kind;
+      Cache *cache;
+      uint32_t video, first, count;
+      Endpoint *endpoint;
+    };
+
+    Instance *instance;
+    std::vector<Entry> entries;
+    std::vector<Endpoint *> returned;
+    bool undoing;
+
+    /**
+     * Undoes one change.
+     * @arg entry The change.
+     */
+    void undo(const Entry &entry);
+
+  public:
+    /**
+     * Constructor. Follows the caches of the instance from now on, starting with an empty journal.
+     * @arg instance The instance to follow.
+     */
+    Journal(Instance *instance);
+
+    /**
+     * Destructor. Stops following the caches of the instance.
+     */
+    ~Journal(void);
+
+    /**
+     * @return A mark for the current point in the journal, to roll back to later.
+     */
+    size_t get_mark(void);
+
+    /**
+     * Undoes all changes made since a mark, latest first, and forgets them.
+     * @arg mark Mark returned by get_mark(), no later than the marks of changes kept since.
+     */
+    void rollback(size_t mark);
+
+    /**
+     * Keeps all changes made so far, and forgets them; marks handed out before become invalid.
+     */
+    void commit(void);
+
+    /**
+     * @return Amount of changes recorded since the last commit().
+     */
+    size_t get_size(void);
+
+    /**
+     * Notification from a cache; see CacheListener.
+     */
+    void video_added(Cache *cache, Request *video);
+
+    /**
+     * Notification from a cache; see CacheListener.
+     */
+    void video_merged(Cache *cache, Request *video);
+
+    /**
+     * Notification from a cache; see CacheListener.
+     */
+    void video_removed(Cache *cache, size_t video_id, Span<Endpoint *const> returned);
+
+    /**
+     * Notification from a cache; see CacheListener.
+     */
+    void request_returned(Cache *cache, Endpoint *endpoint, size_t video_id);
+};
+
+#endif // _JOURNAL_H
@@ -0,0 +1,199 @@
+/***************************************************************************************************
+ *
+ * knapsack.cpp
+ * @author Ben Witzen
+ * @date Feb 27, 2017
+ *
+ * Part of my solution for Google's Hashcode 2017 challenge, submitted during the extended round.
+ *
+ * Function descriptions can be found in knapsack.h
+ *
+ * The AVX2 update is compiled for AVX2 through a target attribute, regardless of the flags the
+ * rest of the program is compiled with, and only called when the processor supports it.
+ *
+ **************************************************************************************************/
+
+#include "knapsack.h"
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define KNAPSACK_AVX2
+#endif
+
+// signature of the update of the table for one item: for every amount from the capacity down to
+// the size of the item, take the item if it beats what fits without it, and mark that in `taken`
+typedef void (*Update)(int64_t *best, uint64_t *taken, size_t capacity, size_t size,
+                       int64_t value);
+
+static void update_scalar(int64_t *best, uint64_t *taken, size_t capacity, size_t size,
+                          int64_t value) {
+  for (size_t c = capacity + 1; c-- > size;)
+    if (best[c - size] + value > best[c]) {
+      best[c] = best[c - size] + value;
+      taken[c / 64] |= (uint64_t) 1 << (c % 64);
+    }
+}
+
+#ifdef KNAPSACK_AVX2
+// blocks of four amounts start at multiples of four, so their bits never straddle two words, and
+// the bits of a word are collected before it is written; a block reads amounts below itself,
+// which the blocks above have not written, before it writes
+__attribute__((target("avx2")))
+static void update_avx2(int64_t *best, uint64_t *taken, size_t capacity, size_t size,
+                        int64_t value) {
+  __m256i add = _mm256_set1_epi64x(value);
+  size_t low = (size + 3) & ~(size_t) 3;
+  uint64_t bits = 0;
+  for (size_t b = (capacity & ~(size_t) 3) + 4; b > low;) {
+    b -= 4;
+    __m256i old = _mm256_loadu_si256((const __m256i *) (best + b));
+    __m256i with = _mm256_add_epi64(_mm256_loadu_si256((const __m256i *) (best + b - size)), add);
+    __m256i better = _mm256_cmpgt_epi64(with, old);
+    _mm256_storeu_si256((__m256i *) (best + b), _mm256_blendv_epi8(old, with, better));
+    bits |= (uint64_t) _mm256_movemask_pd(_mm256_castsi256_pd(better)) << (b % 64);
+    if (b % 64 == 0 || b == low) {
+      taken[b / 64] |= bits;
+      bits = 0;
+    }
+  }
+
+  // amounts below the first whole block
+  for (size_t c = std::min(low, capacity + 1); c-- > size;)
+    if (best[c - size] + value > best[c]) {
+      best[c] = best[c - size] + value;
+      taken[c / 64] |= (uint64_t) 1 << (c % 64);
+    }
+}
+#endif
+
+static bool vectorized(void) {
+#ifdef KNAPSACK_AVX2
+  return __builtin_cpu_supports("avx2");
+#else
+  return false;
+#endif
+}
+
+static const bool use_avx2 = vectorized();
+
+Knapsack::Knapsack(void) {
+  decided = 0;
+}
+
+uint64_t Knapsack::upper_bound(Span<const uint32_t> sizes, Span<const uint64_t> values,
+                               size_t capacity, size_t skip) {
+  // the fractional filling takes whole items by value per MB, and the part of the next one that
+  // fits; find the most items that fit whole
+  size_t n = order.size(), skip_size = sizes[order[skip]];
+  size_t low = 0, high = n;
+  while (low < high) {
+    size_t middle = (low + high + 1) / 2;
+    if (prefix_sizes[middle] - (skip < middle ? skip_size : 0) <= capacity)
+      low = middle;
+    else
+      high = middle - 1;
+  }
+  uint64_t used = prefix_sizes[low] - (skip < low ? skip_size : 0);
+  uint64_t value = prefix_values[low] - (skip < low ? values[order[skip]] : 0);
+
+  // the next item cannot be the skipped one, as that would fit after it
+  if (low < n)
+    value += (unsigned __int128) (capacity - used) * values[order[low]] / sizes[order[low]];
+  return value;
+}
+
+uint64_t Knapsack::solve_open(size_t capacity, std::vector<uint32_t> *chosen) {
+  // no set of items can use more than all of them together
+  size_t total = 0;
+  for (size_t i = 0; i < open.size(); i++)
+    total += open_sizes[i];
+  capacity = std::min(capacity, total);
+
+  // the table is padded to whole blocks of four, and every item gets a row of bits
+  size_t words = (capacity + 4) / 64 + 1;
+  best.assign((capacity & ~(size_t) 3) + 4, 0);
+  taken.assign(open.size() * words, 0);
+  Update update = update_scalar;
+#ifdef KNAPSACK_AVX2
+  if (use_avx2)
+    update = update_avx2;
+#endif
+  for (size_t i = 0; i < open.size(); i++)
+    if (open_sizes[i] <= capacity)
+      update(best.data(), taken.data() + i * words, capacity, open_sizes[i], open_values[i]);
+
+  // walk back from the full capacity, through the items that were taken on the way
+  size_t c = capacity;
+  for (size_t i = open.size(); i-- > 0;)
+    if (taken[i * words + c / 64] >> (c % 64) & 1) {
+      chosen->push_back(open[i]);
+      c -= open_sizes[i];
+    }
+  return best[capacity];
+}
+
+uint64_t Knapsack::solve(Span<const uint32_t> sizes, Span<const uint64_t> values,
+                         size_t capacity, std::vector<uint32_t> *chosen) {
+  chosen->clear();
+
+  // sort the items that can be taken at all by value per MB
+  order.clear();
+  for (size_t i = 0; i < sizes.size(); i++)
+    if (values[i] > 0 && sizes[i] <= capacity)
+      order.push_back(i);
+  std::sort(order.begin(), order.end(), [&sizes, &values](uint32_t a, uint32_t b) {
+    unsigned __int128 left = (unsigned __int128) values[a] * sizes[b];
+    unsigned __int128 right = (unsigned __int128) values[b] * sizes[a];
+    return left > right || (left == right && a < b);
+  });
+  prefix_sizes.assign(1, 0);
+  prefix_values.assign(1, 0);
+  for (size_t k = 0; k < order.size(); k++) {
+    prefix_sizes.push_back(prefix_sizes[k] + sizes[order[k]]);
+    prefix_values.push_back(prefix_values[k] + values[order[k]]);
+  }
+
+  // taking items by value per MB while they fit gives a lower bound
+  uint64_t lower = 0;
+  size_t room = capacity;
+  for (size_t k = 0; k < order.size(); k++)
+    if (sizes[order[k]] <= room) {
+      room -= sizes[order[k]];
+      lower += values[order[k]];
+    }
+
+  // every filling without a taken item, or with a left out one, is worse than the lower bound
+  uint64_t value = 0;
+  size_t used = 0;
+  open.clear();
+  open_sizes.clear();
+  open_values.clear();
+  for (size_t k = 0; k < order.size(); k++) {
+    uint32_t i = order[k];
+    if (upper_bound(sizes, values, capacity, k) < lower) {
+      chosen->push_back(i);
+      value += values[i];
+      used += sizes[i];
+    }
+    else if (values[i] + upper_bound(sizes, values, capacity - sizes[i], k) >= lower) {
+      open.push_back(i);
+      open_sizes.push_back(sizes[i]);
+      open_values.push_back(values[i]);
+    }
+  }
+  decided += order.size() - open.size();
+
+  value += solve_open(capacity - used, chosen);
+  std::sort(chosen->begin(), chosen->end());
+  return value;
+}
+
+size_t Knapsack::get_decided(void) {
+  return decided;
+}
+
+bool Knapsack::is_vectorized(void) {
+  return use_avx2;
+}
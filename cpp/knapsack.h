@@ -0,0 +1,98 @@
+/***************************************************************************************************
+ *
+ * knapsack.h
+ * @author Ben Witzen
+ * @date Feb 27, 2017
+ *
+ * Part of my solution for Google's Hashcode 2017 challenge, submitted during the extended round.
+ *
+ * Defines the Knapsack, which fills a single cache optimally: given videos with their sizes and
+ * the latency each would save, it picks the set that fits the capacity and saves the most. Gains of
+ * different videos in one cache do not influence each other (see gain.h), so this is exactly a
+ * 0/1 knapsack problem.
+ *
+ * Most videos are decided before any dynamic programming: taking videos by gain per MB gives a
+ * lower bound on the best filling, and the fractional filling (the linear relaxation) an upper
+ * bound. A video is certainly taken if leaving it out bounds every filling below the lower bound,
+ * and certainly left out if taking it does. Both bounds are found with a binary search over the
+ * videos sorted by gain per MB, so this costs little more than the sort.
+ *
+ * The videos left undecided are solved by dynamic programming over the capacity they have left:
+ * for every amount of MB, the most that fits into it, updated video by video in place from the
+ * top down. Every video leaves one bit per amount of MB, telling whether it was taken there, from
+ * which the chosen set is read back. The update is the inner loop, and runs four amounts at a
+ * time with AVX2 where the processor has it, as chosen at runtime; other processors run the same
+ * update one amount at a time.
+ *
+ **************************************************************************************************/
+
+#ifndef _KNAPSACK_H
+#define _KNAPSACK_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+#include "span.h"
+
+/**
+ * Knapsack class.
+ */
+class Knapsack {
+  private:
+    std::vector<int64_t> best;
+    std::vector<uint64_t> taken, prefix_sizes, prefix_values;
+    std::vector<uint32_t> order, open_sizes, open;
+    std::vector<uint64_t> open_values;
+    size_t decided;
+
+    /**
+     * Upper bound on the items in `order` but one, by the fractional filling.
+     * @arg sizes Size of every item.
+     * @arg values Value of every item.
+     * @arg capacity Capacity to fill.
+     * @arg skip Position in `order` of the item to leave out.
+     * @return Value of the fractional filling, rounded down.
+     */
+    uint64_t upper_bound(Span<const uint32_t> sizes, Span<const uint64_t> values, size_t capacity,
+                         size_t skip);
+
+    /**
+     * Solves the items in `open` exactly by dynamic programming, and adds the chosen ones to the
+     * list.
+     * @arg capacity Capacity to fill.
+     * @arg chosen List of chosen items to add to.
+     * @return Total value of the chosen items.
+     */
+    uint64_t solve_open(size_t capacity, std::vector<uint32_t> *chosen);
+
+  public:
+    /**
+     * Constructor. The solver keeps its buffers between calls, so that solving many caches does
+     * not allocate every time.
+     */
+    Knapsack(void);
+
+    /**
+     * Picks the most valuable set of items that fits the capacity.
+     * @arg sizes Size of every item, at least 1.
+     * @arg values Value of every item.
+     * @arg capacity Capacity to fill.
+     * @arg chosen Gets overwritten with the indices of the chosen items, in ascending order.
+     * @return Total value of the chosen items.
+     */
+    uint64_t solve(Span<const uint32_t> sizes, Span<const uint64_t> values, size_t capacity,
+                   std::vector<uint32_t> *chosen);
+
+    /**
+     * @return Amount of items decided by the bounds, summed over all calls to solve().
+     */
+    size_t get_decided(void);
+
+    /**
+     * @return true if the update runs with AVX2 on this processor.
+     */
+    static bool is_vectorized(void);
+};
+
+#endif // _KNAPSACK_H
@@ -8,97 +8,433 @@
  *
  * Entry point of program. Handles file I/O, sets up initial objects, and calls the computation.
  *
- * Compile with: make runner a=example
- * Run with ./run infile [passes] > outfile
+ * Compile with: make runner [a=example]
+ * Run with ./run [-a algorithms] [-t threads] [-r | -c] [-v] [-T tracefile] [-s solution]
+ *            [-S seconds [-R seed]] [-B seconds] [-C seconds] infile outfile [passes]
+ *   -a  name of the algorithm to run, as its file in algorithms/ is named without .cpp; several
+ *       names separated by commas, or `all`, run each of them in turn on a fresh copy of the
+ *       instance, which is only parsed once, and write the best solution; defaults to the
+ *       algorithm given to make
+ *   -t  run each pass on this many threads (0: one per core); default 1
+ *   -r  relaxed mode: endpoints sharing a cache may run concurrently, so results can differ
+ *       between runs; by default, passes on several threads reproduce the serial result, and
+ *       algorithms that keep state across endpoints (see algorithms/compute.h) run on one thread
+ *   -c  solve each connected component of the endpoint-cache graph on its own, running all
+ *       passes over one component before moving on; reproduces the serial result; algorithms
+ *       that keep state across endpoints run their passes over the whole instance instead
+ *   -v  print the endpoints visited, videos placed, requests merged and time taken in every pass
+ *   -T  write counters and timings of every pass into tracefile (see trace.h); a name ending in
+ *       .json gets the Chrome trace format, other names get one line of JSON per pass; with -c,
+ *       all passes make up a single record
+ *   -s  start from the videos stored by a solution file, such as an earlier outfile, instead of
+ *       from empty caches
+ *   -S  after the computation, improve the solution by local search for this many seconds, with
+ *       one searcher per thread (see search.h)
+ *   -R  seed of the local search; default 1
+ *   -B  anytime mode: stop after this many seconds of wall-clock time, counted from the start of
+ *       the program; the budget left after parsing is shared evenly by the algorithms, and each
+ *       spends what its passes leave of its share on local search, instead of the time given by
+ *       -S; prepare() and the passes stop early when the share runs out
+ *   -C  anytime mode: write the best solution so far to outfile every this many seconds, and on
+ *       SIGTERM (see checkpoint.h); default 60 with -B
+ *
+ * Every algorithm runs the amount of passes it registers (see algorithms/compute.h), unless passes
+ * is given: one amount per algorithm, separated by commas, where an empty amount keeps the one the
+ * algorithm registers. An amount of 0 runs until no endpoint can change anymore (see scheduler.h),
+ * which only algorithms whose compute() ignores the pass number can do, and not with -c; with -c,
+ * such algorithms run a single pass unless given an amount.
  *
  **************************************************************************************************/
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <iostream>
 #include <stdio.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
 
+#include "checkpoint.h"
+#include "executor.h"
+#include "instance.h"
+#include "scheduler.h"
+#include "scorer.h"
+#include "search.h"
+#include "trace.h"
 #include "youtube.h"
 #include "algorithms/compute.h"
 
+// algorithm to run without -a, filled in by make runner a=name
+#ifndef ALGORITHM_NAME
+#define ALGORITHM_NAME ""
+#endif
+
+// time between two checkpoints in anytime mode, unless given with -C
+static const double CHECKPOINT_INTERVAL = 60;
+
+// options that apply to every algorithm that runs
+struct Settings {
+  size_t threads, seed;
+  double search_time;
+  bool deterministic, by_component, verbose;
+  const char *start_path;
+  Trace *trace;
+
+  // anytime mode: the budget and the time between checkpoints in seconds, the end of the current
+  // algorithm's share of the budget, and where to offer solutions while computing
+  double budget, checkpoint_interval;
+  std::chrono::steady_clock::time_point until;
+  Checkpoint *checkpoint;
+};
+
+/**
+ * Runs one algorithm on an instance: prepare(), the passes and, if requested, the local search.
+ * In anytime mode, solutions are offered to the checkpoint while computing.
+ * @arg algorithm The algorithm to run.
+ * @arg instance The instance to solve; its caches should not store any videos yet.
+ * @arg settings Options from the command line.
+ * @arg passes Amount of passes; 0 means until nothing changes.
+ * @arg score Gets overwritten with the score of the solution.
+ * @return true on success, false if the solution to start from cannot be read.
+ */
+static bool solve(const Algorithm *algorithm, Instance *instance, const Settings &settings,
+                  size_t passes, uint64_t *score) {
+  using namespace std;
+  Trace *trace = settings.trace;
+
+  // keep track of the score while computing
+  Scorer *scorer = new Scorer(instance);
+
+  // continue from an earlier solution, if requested
+  if (settings.start_path) {
+    if (!instance->load_solution(settings.start_path)) {
+      cerr << instance->get_error() << endl;
+      delete scorer;
+      return false;
+    }
+    cerr << "Started from " << settings.start_path << ", which scores " << scorer->get_score()
+         << endl;
+  }
+
+  // offer the solution to start from right away, so that the outfile holds one from the start
+  if (settings.checkpoint)
+    settings.checkpoint->offer(instance, scorer->get_score());
+
+  // algorithms that keep state across endpoints only reproduce the serial result on one thread,
+  // so they fall back from -c to serial passes, and take several threads only in relaxed mode
+  bool by_component = settings.by_component && algorithm->endpoint_local;
+  bool serial = !algorithm->endpoint_local && (settings.deterministic || settings.by_component);
+  Executor *executor = new Executor(instance, serial ? 1 : settings.threads,
+                                    settings.deterministic);
+
+  // invoke computation; prepare once on the threads of the executor, then call each endpoint
+  // once per pass
+  Deadline deadline(scorer, settings.checkpoint, settings.budget > 0, settings.until);
+  algorithm->prepare(instance, executor, &deadline);
+  cerr << "Threads:   " << executor->get_threads();
+  if (serial && (settings.by_component || settings.threads != 1))
+    cerr << " (" << algorithm->name << " keeps state across endpoints, so runs serially)";
+  if (by_component) {
+    Components *components = new Components(instance);
+    cerr << " (" << components->get_amount() << " components";
+    if (components->get_amount() > 0)
+      cerr << ", biggest has " << components->get_endpoints(0).size() << " endpoints and "
+           << components->get_caches(0).size() << " caches";
+    cerr << ")" << endl;
+    if (trace)
+      trace->begin_pass();
+    algorithm->run_components(executor, components, passes);
+    if (trace)
+      trace->end_pass(0, passes * instance->get_endpoints_amount());
+    delete components;
+  }
+  else {
+    if (executor->get_threads() > 1)
+      cerr << (settings.deterministic ? " (deterministic, " +
+                                        to_string(executor->get_batches_amount()) +
+                                        " batches per pass)" : " (relaxed)");
+    cerr << endl;
+
+    // run passes until the amount is reached or nothing can change anymore
+    Scheduler *scheduler = new Scheduler(instance, executor, algorithm->pass_independent);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    size_t p = 0, visits = 0, placements = 0;
+    bool out_of_time = false;
+    if (settings.verbose)
+      fprintf(stderr, "%8s %10s %10s %10s %10s\n", "pass", "visits", "placed", "merged", "ms");
+    while (passes == 0 || p < passes) {
+      chrono::steady_clock::time_point pass_start = chrono::steady_clock::now();
+      if (trace)
+        trace->begin_pass();
+      algorithm->run_pass(scheduler, p++);
+      if (trace)
+        trace->end_pass(p - 1, scheduler->get_visits());
+      visits += scheduler->get_visits();
+      placements += scheduler->get_placements();
+      if (settings.verbose)
+        fprintf(stderr, "%8lu %10lu %10lu %10lu %10.3f\n", p - 1, scheduler->get_visits(),
+                scheduler->get_placements(), scheduler->get_merges(),
+                chrono::duration<double, milli>(chrono::steady_clock::now() - pass_start).count());
+      if (algorithm->pass_independent && scheduler->is_converged())
+        break;
+
+      // the threads are idle between passes, so the caches can be read
+      if (settings.checkpoint && settings.checkpoint->is_due())
+        settings.checkpoint->offer(instance, scorer->get_score());
+      if (settings.budget > 0 && chrono::steady_clock::now() >= settings.until) {
+        out_of_time = passes == 0 || p < passes;
+        break;
+      }
+    }
+    double compute_time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    bool converged = algorithm->pass_independent && scheduler->is_converged();
+    fprintf(stderr, "Ran %lu passes in %.3f s: %lu endpoint visits, %lu videos placed%s\n", p,
+            compute_time, visits, placements, converged ? ", nothing left to change" :
+            out_of_time ? ", out of time" : "");
+    delete scheduler;
+  }
+  delete executor;
+
+  // improve the solution by local search, if requested; in anytime mode, until the share runs out
+  double search_time = settings.search_time;
+  if (settings.budget > 0)
+    search_time = max(0.0, chrono::duration<double>(settings.until -
+                                                    chrono::steady_clock::now()).count());
+  if (search_time > 0) {
+    Search *search = new Search(instance, settings.threads);
+    if (settings.checkpoint) {
+      settings.checkpoint->offer(instance, scorer->get_score());
+      search->set_listener(settings.checkpoint, settings.checkpoint_interval);
+    }
+    search->run(search_time, settings.seed);
+    search->apply();
+    fprintf(stderr, "Searched %.1f s on %lu threads: %lu moves, %lu accepted, %lu exchanges, "
+            "score %lu -> %lu\n", search_time, search->get_threads(),
+            search->get_moves(), search->get_accepted(), search->get_epochs(),
+            search->get_start_score(), search->get_score());
+    delete search;
+  }
+
+  *score = scorer->get_score();
+  delete scorer;
+  return true;
+}
+
 int main(int argc, char **argv) {
   using namespace std;
+  chrono::steady_clock::time_point program_start = chrono::steady_clock::now();
   
+  // read options
+  const char *program = argv[0], *trace_path = NULL, *names = ALGORITHM_NAME;
+  Settings settings = {1, 1, 0, true, false, false, NULL, NULL, 0, 0,
+                       chrono::steady_clock::time_point(), NULL};
+  int option;
+  while ((option = getopt(argc, argv, "a:t:rcvT:s:S:R:B:C:")) != -1) {
+    if (option == 'a')
+      names = optarg;
+    else if (option == 't')
+      settings.threads = atoi(optarg);
+    else if (option == 'r')
+      settings.deterministic = false;
+    else if (option == 'c')
+      settings.by_component = true;
+    else if (option == 'v')
+      settings.verbose = true;
+    else if (option == 'T')
+      trace_path = optarg;
+    else if (option == 's')
+      settings.start_path = optarg;
+    else if (option == 'S')
+      settings.search_time = atof(optarg);
+    else if (option == 'R')
+      settings.seed = atoi(optarg);
+    else if (option == 'B')
+      settings.budget = atof(optarg);
+    else if (option == 'C')
+      settings.checkpoint_interval = atof(optarg);
+    else
+      return 1;
+  }
+  argc -= optind - 1;
+  argv += optind - 1;
+
   // usage instructions
-  if (argc < 3) {
-    cerr << "Usage: " << argv[0] << " infile outfile [passes]" << endl;
+  if (argc < 3 || !*names) {
+    cerr << "Usage: " << program << " [-a algorithms] [-t threads] [-r | -c] [-v] [-T tracefile] "
+            "[-s solution] [-S seconds [-R seed]] [-B seconds] [-C seconds] infile outfile "
+            "[passes]" << endl;
+    cerr << "Algorithms:";
+    for (size_t i = 0; i < get_algorithms().size(); i++)
+      cerr << " " << get_algorithms()[i]->name;
+    cerr << endl;
     return 0;
   }
 
-  // get amount of passes
-  size_t passes = argc > 3 ? atoi(argv[3]) : 1;
+  // look up the algorithms by name
+  vector<const Algorithm *> algorithms;
+  if (strcmp(names, "all") == 0)
+    algorithms = get_algorithms();
+  else {
+    string list = names;
+    for (size_t from = 0, to; from <= list.size(); from = to + 1) {
+      to = min(list.find(',', from), list.size());
+      const Algorithm *algorithm = find_algorithm(list.substr(from, to - from).c_str());
+      if (!algorithm) {
+        cerr << "Unknown algorithm: " << list.substr(from, to - from) << endl;
+        return 1;
+      }
+      algorithms.push_back(algorithm);
+    }
+  }
 
-  // notify of settings
-  cerr << "Algorithm: " << ALGORITHM_NAME << endl;
-  cerr << "Passes:    " << passes << endl;
-  
-  // open file
-  FILE *in = fopen(argv[1], "r");
-  if (!in) {
-    cerr << "Cannot open " << argv[1] << endl;
-    return 0;
+  // get amount of passes of every algorithm; 0 means until nothing changes
+  vector<size_t> passes;
+  string amounts = argc > 3 ? argv[3] : string(algorithms.size() - 1, ',');
+  if ((size_t) count(amounts.begin(), amounts.end(), ',') != algorithms.size() - 1) {
+    cerr << "Give one amount of passes per algorithm, separated by commas" << endl;
+    return 1;
   }
-  
-  // read infile, header
-  size_t videos_amt, endpoints_amt, requests_amt, caches_amt, caches_size;
-  fscanf(in, "%lu %lu %lu %lu %lu\n", &videos_amt, &endpoints_amt, &requests_amt, &caches_amt,
-                                 &caches_size);
-
-  // read infile, video sizes
-  size_t requests_size[videos_amt];
-  for (size_t i = 0; i < videos_amt; i++)
-    fscanf(in, "%lu", &requests_size[i]);
-
-  // create caches
-  Cache *caches[caches_amt];
-  for (size_t i = 0; i < caches_amt; i++)
-    caches[i] = new Cache(caches_size);
-
-  // read infile, create endpoints and link endpoints <-> caches
-  Endpoint *endpoints[endpoints_amt];
-  for (size_t endp = 0; endp < endpoints_amt; endp++) {
-    size_t latency, caches_amt;
-    fscanf(in, "%lu %lu\n", &latency, &caches_amt);
-    endpoints[endp] = new Endpoint(latency);
-    for (size_t i = 0; i < caches_amt; i++) {
-      size_t id, latency;
-      fscanf(in, "%lu %lu\n", &id, &latency);
-      endpoints[endp]->add_cache(caches[id], latency);
+  for (size_t i = 0, from = 0, to; i < algorithms.size(); i++, from = to + 1) {
+    bool by_component = settings.by_component && algorithms[i]->endpoint_local;
+    bool open = algorithms[i]->pass_independent && !by_component;
+    to = min(amounts.find(',', from), amounts.size());
+    if (to > from)
+      passes.push_back(atoi(amounts.substr(from, to - from).c_str()));
+    else
+      passes.push_back(algorithms[i]->passes > 0 || open ? algorithms[i]->passes : 1);
+    if (passes[i] == 0 && !open) {
+      cerr << "The amount of passes can only be left open for algorithms that ignore the pass "
+              "number, and not with -c" << endl;
+      return 1;
     }
   }
-  
-  // read infile, create video requests and assign them to endpoints
-  for (size_t i = 0; i < requests_amt; i++) {
-    size_t request, endpoint, weight;
-    fscanf(in, "%lu %lu %lu\n", &request, &endpoint, &weight);
-    Request *n = new Request(request, requests_size[request], weight);
-    endpoints[endpoint]->add_request(n);
+
+  // open tracefile, if requested
+  if (trace_path) {
+    settings.trace = new Trace();
+    if (!settings.trace->open(trace_path)) {
+      cerr << settings.trace->get_error() << endl;
+      delete settings.trace;
+      return 1;
+    }
   }
-  
-  fclose(in);
+
+  // read infile
+  chrono::steady_clock::time_point parse_start = chrono::steady_clock::now();
+  Instance *instance = new Instance();
+  if (!instance->load(argv[1])) {
+    cerr << instance->get_error() << endl;
+    delete instance;
+    delete settings.trace;
+    return 1;
+  }
+
+  // report parse throughput
+  double parse_time = chrono::duration<double>(chrono::steady_clock::now() - parse_start).count();
+  fprintf(stderr, "Parsed %.1f MB in %.3f s (%.1f MB/s)\n", instance->get_input_size() / 1e6,
+          parse_time, instance->get_input_size() / 1e6 / parse_time);
   cerr << "Infile has been read. Starting computation..." << endl;
-  
-  // invoke computation; call each endpoint once per pass
-  float calls_amt = passes * endpoints_amt;
-  for (size_t p = 0; p < passes; p++)
-    for (size_t i = 0; i < endpoints_amt; i++)
-      compute(endpoints[i], p);
 
+  // anytime mode: keep outfile up to date from here on
+  chrono::steady_clock::time_point deadline = program_start +
+                                              chrono::duration_cast<chrono::steady_clock::duration>(
+                                                  chrono::duration<double>(settings.budget));
+  if (settings.budget > 0 || settings.checkpoint_interval > 0) {
+    if (settings.checkpoint_interval <= 0)
+      settings.checkpoint_interval = CHECKPOINT_INTERVAL;
+    settings.checkpoint = new Checkpoint(argv[2], settings.checkpoint_interval);
+    settings.checkpoint->catch_termination();
+    cerr << "Anytime:   checkpoints every " << settings.checkpoint_interval << " s";
+    if (settings.budget > 0)
+      cerr << ", " << settings.budget << " s budget";
+    cerr << endl;
+  }
+
+  // run every algorithm on its own copy, keeping the best solution; a single one gets the original
+  Instance *best = NULL;
+  uint64_t best_score = 0;
+  vector<uint64_t> scores;
+  vector<double> times;
+  for (size_t i = 0; i < algorithms.size(); i++) {
+    // in anytime mode, each algorithm gets an even share of what is left of the budget
+    if (settings.budget > 0) {
+      chrono::steady_clock::time_point now = chrono::steady_clock::now();
+      if (best && now >= deadline) {
+        cerr << "Out of time, skipping the remaining algorithms" << endl;
+        break;
+      }
+      settings.until = now + (deadline - now) / (algorithms.size() - i);
+    }
+    cerr << "Algorithm: " << algorithms[i]->name << endl;
+    cerr << "Passes:    " << (passes[i] ? to_string(passes[i]) : "until done") << endl;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    Instance *copy = algorithms.size() > 1 ? instance->clone() : instance;
+    uint64_t score;
+    if (!solve(algorithms[i], copy, settings, passes[i], &score)) {
+      if (copy != instance)
+        delete copy;
+      delete best;
+      delete instance;
+      delete settings.trace;
+      delete settings.checkpoint;
+      return 1;
+    }
+    scores.push_back(score);
+    times.push_back(chrono::duration<double>(chrono::steady_clock::now() - start).count());
+    cerr << "Score:     " << score << endl;
+    if (settings.checkpoint)
+      settings.checkpoint->offer(copy, score);
+    if (!best || score > best_score) {
+      if (best != instance)
+        delete best;
+      best = copy;
+      best_score = score;
+    }
+    else if (copy != instance)
+      delete copy;
+  }
+  delete settings.trace;
+
+  // compare the algorithms, if several ran
+  if (algorithms.size() > 1) {
+    fprintf(stderr, "%-10s %12s %10s\n", "algorithm", "score", "s");
+    for (size_t i = 0; i < scores.size(); i++)
+      fprintf(stderr, "%-10s %12lu %10.3f%s\n", algorithms[i]->name, scores[i], times[i],
+              scores[i] == best_score ? " *" : "");
+  }
   cerr << "Computation done, writing outfile." << endl;
 
+  // in anytime mode, the checkpoint writes the outfile the way it wrote every checkpoint
+  if (settings.checkpoint) {
+    settings.checkpoint->offer(best, best_score);
+    bool written = settings.checkpoint->finish();
+    if (written)
+      cerr << "Wrote " << settings.checkpoint->get_writes() << " checkpoints, the last one scores "
+           << settings.checkpoint->get_score() << endl;
+    else
+      cerr << settings.checkpoint->get_error() << endl;
+    delete settings.checkpoint;
+    if (best != instance)
+      delete best;
+    delete instance;
+    return written ? 0 : 1;
+  }
+
   // write outfile
   FILE *out = fopen(argv[2], "w");
-  fprintf(out, "%lu\n", caches_amt);
-  for (size_t i = 0; i < caches_amt; i++)
-    caches[i]->print_raw(out);
+  if (!out) {
+    cerr << "Cannot open " << argv[2] << endl;
+    if (best != instance)
+      delete best;
+    delete instance;
+    return 1;
+  }
+  best->print_raw(out);
   fclose(out);
   
   // cleanup
-  for (size_t i = 0; i < endpoints_amt; i++)
-    delete endpoints[i];
-  for (size_t i = 0; i < caches_amt; i++)
-    delete caches[i];
-}
\ No newline at end of file
+  if (best != instance)
+    delete best;
+  delete instance;
+}
@@ -0,0 +1,176 @@
+/***************************************************************************************************
+ *
+ * parser.cpp
+ * @author Ben Witzen
+ * @date Feb 27, 2017
+ *
+ * Part of my solution for Google's Hashcode 2017 challenge, submitted during the extended round.
+ *
+ * Function descriptions can be found in parser.h
+ *
+ **************************************************************************************************/
+
+#include "parser.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// broadcasts a byte into all eight bytes of a word
+#define BYTES(b) (0x0101010101010101ULL * (b))
+
+Parser::Parser(void) {
+  data = cursor = end = line_start = NULL;
+  length = 0;
+  line = token_line = token_column = 1;
+  path = "";
+}
+
+Parser::~Parser(void) {
+  if (data && length > 0)
+    munmap((void *) data, length);
+}
+
+bool Parser::open(const char *path) {
+  this->path = path;
+
+  int fd = ::open(path, O_RDONLY);
+  if (fd < 0)
+    return fail(0, 0, std::string("cannot open: ") + strerror(errno));
+
+  struct stat st;
+  if (fstat(fd, &st) < 0) {
+    close(fd);
+    return fail(0, 0, std::string("cannot stat: ") + strerror(errno));
+  }
+  length = st.st_size;
+
+  // an empty file cannot be mapped, but is handled as input without any integers
+  if (length > 0) {
+    void *map = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+      close(fd);
+      length = 0;
+      return fail(0, 0, std::string("cannot map: ") + strerror(errno));
+    }
+    madvise(map, length, MADV_SEQUENTIAL);
+    data = (const char *) map;
+  }
+  close(fd);
+
+  cursor = line_start = data;
+  end = data + length;
+  line = 1;
+  return true;
+}
+
+void Parser::skip_whitespace(void) {
+  while (cursor < end) {
+    char c = *cursor;
+    if (c == '\n') {
+      line++;
+      line_start = ++cursor;
+    }
+    else if (c == ' ' || c == '\t' || c == '\r')
+      cursor++;
+    else
+      break;
+  }
+}
+
+bool Parser::next(size_t *value) {
+  skip_whitespace();
+  token_line = line;
+  token_column = cursor - line_start + 1;
+
+  if (cursor == end)
+    return fail(token_line, token_column, "unexpected end of file, expected an integer");
+  if (*cursor < '0' || *cursor > '9')
+    return fail(token_line, token_column, std::string("expected an integer, got '") + *cursor +
+                                          "'");
+
+  uint64_t result = 0;
+
+  // convert up to eight digits at once while a full word is available
+  while (cursor + 8 <= end) {
+    uint64_t word;
+    memcpy(&word, cursor, 8);
+
+    // a byte is a digit if its high nibble is 3, and still is after adding 6
+    uint64_t non_digits = ((word & BYTES(0xF0)) ^ BYTES(0x30)) |
+                          (((word + BYTES(0x06)) & BYTES(0xF0)) ^ BYTES(0x30));
+    uint64_t flags = (((non_digits & BYTES(0x7F)) + BYTES(0x7F)) | non_digits) & BYTES(0x80);
+    size_t digits = flags ? __builtin_ctzll(flags) / 8 : 8;
+    if (digits == 0)
+      break;
+
+    // move the digits to the most significant bytes, so the zeroed bytes act as leading zeros
+    word = (word & BYTES(0x0F)) << (8 * (8 - digits));
+    word = (word * 10 + (word >> 8)) & 0x00FF00FF00FF00FFULL;
+    word = (word * 100 + (word >> 16)) & 0x0000FFFF0000FFFFULL;
+    word = (word * 10000 + (word >> 32)) & 0x00000000FFFFFFFFULL;
+
+    static const uint64_t scale[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000,
+                                     100000000};
+    if (result > (UINT64_MAX - word) / scale[digits])
+      return fail(token_line, token_column, "integer does not fit in 64 bits");
+    result = result * scale[digits] + word;
+    cursor += digits;
+    if (digits < 8)
+      break;
+  }
+
+  // near the end of the file, fall back to one digit at a time
+  while (cursor < end && *cursor >= '0' && *cursor <= '9') {
+    uint64_t digit = *cursor - '0';
+    if (result > (UINT64_MAX - digit) / 10)
+      return fail(token_line, token_column, "integer does not fit in 64 bits");
+    result = result * 10 + digit;
+    cursor++;
+  }
+
+  // integers must be separated by whitespace
+  if (cursor < end && *cursor != ' ' && *cursor != '\n' && *cursor != '\t' && *cursor != '\r')
+    return fail(line, cursor - line_start + 1, std::string("unexpected character '") + *cursor +
+                                               "' after integer");
+
+  *value = result;
+  return true;
+}
+
+bool Parser::at_end_of_line(void) {
+  while (cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\r'))
+    cursor++;
+  return cursor == end || *cursor == '\n';
+}
+
+bool Parser::finish(void) {
+  skip_whitespace();
+  if (cursor != end)
+    return fail(line, cursor - line_start + 1, "unexpected data after the last integer");
+  return true;
+}
+
+bool Parser::reject(const std::string &reason) {
+  return fail(token_line, token_column, reason);
+}
+
+bool Parser::fail(size_t line, size_t column, const std::string &reason) {
+  error = path;
+  if (line > 0)
+    error += ":" + std::to_string(line) + ":" + std::to_string(column);
+  error += ": " + reason;
+  return false;
+}
+
+const char *Parser::get_error(void) {
+  return error.c_str();
+}
+
+size_t Parser::get_size(void) {
+  return length;
+}
@@ -0,0 +1,104 @@
+/***************************************************************************************************
+ *
+ * parser.h
+ * @author Ben Witzen
+ * @date Feb 27, 2017
+ *
+ * Part of my solution for Google's Hashcode 2017 challenge, submitted during the extended round.
+ *
+ * Defines the Parser, which reads the unsigned integers that make up an input file.
+ *
+ * The input file is memory-mapped and scanned in place; no libc calls are made per field. Digits
+ * are converted up to eight at a time by treating the bytes as one 64-bit word. Any malformed
+ * input (stray characters, missing fields, numbers that overflow) is rejected with the line and
+ * column where the problem was found, instead of leaving values uninitialized.
+ *
+ **************************************************************************************************/
+
+#ifndef _PARSER_H
+#define _PARSER_H
+
+#include <cstddef>
+#include <string>
+
+/**
+ * Parser class.
+ */
+class Parser {
+  private:
+    const char *data, *cursor, *end, *line_start;
+    size_t length, line, token_line, token_column;
+    const char *path;
+    std::string error;
+
+    /**
+     * Moves the cursor past any whitespace, keeping track of line numbers.
+     */
+    void skip_whitespace(void);
+
+    /**
+     * Records an error at the given position.
+     * @arg line Line number, starting at 1.
+     * @arg column Column number, starting at 1.
+     * @arg reason Human readable description of the problem.
+     * @return false.
+     */
+    bool fail(size_t line, size_t column, const std::string &reason);
+
+  public:
+    /**
+     * Constructor.
+     */
+    Parser(void);
+
+    /**
+     * Destructor.
+     * Unmaps the input file, if one was opened.
+     */
+    ~Parser(void);
+
+    /**
+     * Memory-maps a file for parsing.
+     * @arg path Path to the input file.
+     * @return true on success, false on failure (see get_error()).
+     */
+    bool open(const char *path);
+
+    /**
+     * Reads the next unsigned integer from the input.
+     * @arg value Gets overwritten with the integer read.
+     * @return true on success, false on malformed input or end of file (see get_error()).
+     */
+    bool next(size_t *value);
+
+    /**
+     * Checks whether the line of the last integer read has more integers on it.
+     * @return true if only spaces remain before the end of the line or file.
+     */
+    bool at_end_of_line(void);
+
+    /**
+     * Checks that nothing but whitespace follows the last integer read.
+     * @return true if the input is exhausted, false otherwise (see get_error()).
+     */
+    bool finish(void);
+
+    /**
+     * Rejects the integer that was read last, for example because it is out of range.
+     * @arg reason Human readable description of the problem.
+     * @return false, so callers can write `return parser.reject(...)`.
+     */
+    bool reject(const std::string &reason);
+
+    /**
+     * @return Description of the last error, prefixed with path, line and column.
+     */
+    const char *get_error(void);
+
+    /**
+     * @return Size of the input file in bytes.
+     */
+    size_t get_size(void);
+};
+
+#endif // _PARSER_H
@@ -0,0 +1,70 @@
+/***************************************************************************************************
+ *
+ * scheduler.cpp
+ * @author Ben Witzen
+ * @date Feb 27, 2017
+ *
+ * Part of my solution for Google's Hashcode 2017 challenge, submitted during the extended round.
+ *
+ * Implementation of the Scheduler. See scheduler.h for details.
+ *
+ **************************************************************************************************/
+
+#include "scheduler.h"
+
+Scheduler::Scheduler(Instance *instance, Executor *executor, bool independent)
+    : instance(instance), executor(executor), independent(independent),
+      pending(instance->get_endpoints_amount(), 1), all(instance->get_endpoints_amount()),
+      visits(0), placements(0), merges(0), pending_amt(pending.size()) {
+  for (size_t e = 0; e < all.size(); e++)
+    all[e] = e;
+  instance->add_listener(this);
+}
+
+Scheduler::~Scheduler(void) {
+  instance->remove_listener(this);
+}
+
+bool Scheduler::is_independent(void) {
+  return independent;
+}
+
+bool Scheduler::is_converged(void) {
+  return pending_amt == 0;
+}
+
+size_t Scheduler::get_visits(void) {
+  return visits;
+}
+
+size_t Scheduler::get_placements(void) {
+  return placements;
+}
+
+size_t Scheduler::get_merges(void) {
+  return merges;
+}
+
+void Scheduler::video_added(Cache *cache, Request *video) {
+  // every endpoint of the cache may now merge a request into this video
+  Span<const uint32_t> endpoints = instance->get_cache_endpoints(cache->get_id());
+  for (size_t i = 0; i < endpoints.size(); i++)
+    __atomic_store_n(&pending[endpoints[i]], 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&placements, 1, __ATOMIC_RELAXED);
+}
+
+void Scheduler::video_merged(Cache *cache, Request *video) {
+  __atomic_fetch_add(&merges, 1, __ATOMIC_RELAXED);
+}
+
+void Scheduler::video_removed(Cache *cache, size_t video_id, Span<Endpoint *const> returned) {
+  // the freed space may now fit a video of any endpoint of the cache
+  Span<const uint32_t> endpoints = instance->get_cache_endpoints(cache->get_id());
+  for (size_t i = 0; i < endpoints.size(); i++)
+    __atomic_store_n(&pending[endpoints[i]], 1, __ATOMIC_RELAXED);
+}
+
+void Scheduler::request_returned(Cache *cache, Endpoint *endpoint, size_t video_id) {
+  if (endpoint != NULL)
+    __atomic_store_n(&pending[endpoint->get_id()], 1, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,137 @@
+/***************************************************************************************************
+ *
+ * scheduler.h
+ * @author Ben Witzen
+ * @date Feb 27, 2017
+ *
+ * Part of my solution for Google's Hashcode 2017 challenge, submitted during the extended round.
+ *
+ * Defines the Scheduler, which runs passes of a compute() function through an Executor but skips
+ * the endpoints that cannot do anything new.
+ *
+ * An endpoint is pending when its requests changed during its last visit, or when since then a
+ * video was added to or removed from one of its caches, or a request was handed back to it; the
+ * Scheduler registers itself with every cache to notice the latter. Otherwise its caches only lost
+ * free space, so an endpoint that changed nothing would change nothing on its next visit either --
+ * provided compute() ignores the pass number. For such compute() functions only pending endpoints
+ * are visited, and the computation has reached a fixpoint once no endpoint is pending. Pending
+ * flags are checked at the moment an endpoint's turn comes, so a pass makes exactly the same
+ * changes as a full pass would. For compute() functions that do depend on the pass number, every
+ * endpoint is visited in every pass.
+ *
+ **************************************************************************************************/
+
+#ifndef _SCHEDULER_H
+#define _SCHEDULER_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+#include "executor.h"
+#include "instance.h"
+#include "youtube.h"
+
+/**
+ * Scheduler class.
+ */
+class Scheduler : public CacheListener {
+  private:
+    Instance *instance;
+    Executor *executor;
+    bool independent;
+    std::vector<uint8_t> pending;
+    std::vector<uint32_t> all;
+    size_t visits, placements, merges, pending_amt;
+
+  public:
+    /**
+     * Constructor. Marks all endpoints as pending, and follows the caches of the instance from
+     * then on.
+     * @arg instance The instance whose endpoints to run.
+     * @arg executor Executor to run the passes on.
+     * @arg independent true if compute() ignores the pass number, so endpoints can be skipped.
+     */
+    Scheduler(Instance *instance, Executor *executor, bool independent);
+
+    /**
+     * Destructor. Stops following the caches of the instance.
+     */
+    ~Scheduler(void);
+
+    /**
+     * Runs one pass: calls F for every pending endpoint, or for every endpoint if F depends on the
+     * pass number.
+     * @arg pass Pass number, handed to F.
+     */
+    template <void (*F)(Endpoint *, size_t)>
+    void run_pass(size_t pass) {
+      Instance *instance = this->instance;
+      uint8_t *pending = this->pending.data();
+      size_t *visits = &this->visits;
+      bool independent = this->independent;
+      this->visits = placements = merges = pending_amt = 0;
+
+      executor->run(Span<const uint32_t>(all.data(), all.size()), [=](size_t e) {
+        if (independent && !__atomic_exchange_n(&pending[e], 0, __ATOMIC_RELAXED))
+          return;
+        Endpoint *endpoint = instance->get_endpoint(e);
+        size_t before = endpoint->get_requests_amount();
+        F(endpoint, pass);
+        if (endpoint->get_requests_amount() != before)
+          __atomic_store_n(&pending[e], 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(visits, 1, __ATOMIC_RELAXED);
+      });
+
+      for (size_t e = 0; e < all.size(); e++)
+        pending_amt += this->pending[e];
+    }
+
+    /**
+     * @return true if compute() ignores the pass number, so passes can skip endpoints.
+     */
+    bool is_independent(void);
+
+    /**
+     * @return true if the last pass changed nothing that a next pass could build on; only
+     *         meaningful if is_independent().
+     */
+    bool is_converged(void);
+
+    /**
+     * @return Amount of endpoints visited in the last pass.
+     */
+    size_t get_visits(void);
+
+    /**
+     * @return Amount of videos added to a cache in the last pass.
+     */
+    size_t get_placements(void);
+
+    /**
+     * @return Amount of requests merged into a video already in a cache in the last pass.
+     */
+    size_t get_merges(void);
+
+    /**
+     * Notification from a cache; see CacheListener.
+     */
+    void video_added(Cache *cache, Request *video);
+
+    /**
+     * Notification from a cache; see CacheListener.
+     */
+    void video_merged(Cache *cache, Request *video);
+
+    /**
+     * Notification from a cache; see CacheListener.
+     */
+    void video_removed(Cache *cache, size_t video_id, Span<Endpoint *const> returned);
+
+    /**
+     * Notification from a cache; see CacheListener.
+     */
+    void request_returned(Cache *cache, Endpoint *endpoint, size_t video_id);
+};
+
+#endif // _SCHEDULER_H
@@ -0,0 +1,63 @@
+/***************************************************************************************************
+ *
+ * score.cpp
+ * @author Ben Witzen
+ * @date Feb 27, 2017
+ *
+ * Part of my solution for Google's Hashcode 2017 challenge, submitted during the extended round.
+ *
+ * Entry point of the scorer. Checks a solution file against an input file and prints its score.
+ *
+ * Compile with: make score
+ * Run with ./score infile outfile
+ *
+ **************************************************************************************************/
+
+#include <chrono>
+#include <iostream>
+#include <stdio.h>
+#include <vector>
+
+#include "instance.h"
+#include "scorer.h"
+
+int main(int argc, char **argv) {
+  using namespace std;
+
+  // usage instructions
+  if (argc < 3) {
+    cerr << "Usage: " << argv[0] << " infile outfile" << endl;
+    return 0;
+  }
+
+  // read infile
+  Instance *instance = new Instance();
+  if (!instance->load(argv[1])) {
+    cerr << instance->get_error() << endl;
+    delete instance;
+    return 1;
+  }
+
+  // read and check outfile
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  vector<vector<uint32_t> > contents;
+  if (!instance->read_solution(argv[2], &contents)) {
+    cerr << instance->get_error() << endl;
+    delete instance;
+    return 1;
+  }
+
+  // score it
+  Scorer *scorer = new Scorer(instance);
+  for (size_t c = 0; c < contents.size(); c++)
+    for (size_t v = 0; v < contents[c].size(); v++)
+      scorer->add(c, contents[c][v]);
+  double time = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+  printf("%lu\n", scorer->get_score());
+  fprintf(stderr, "Scored %s in %.3f ms\n", argv[2], time);
+
+  // cleanup
+  delete scorer;
+  delete instance;
+}
@@ -0,0 +1,96 @@
+/***************************************************************************************************
+ *
+ * scorer.cpp
+ * @author Ben Witzen
+ * @date Feb 27, 2017
+ *
+ * Part of my solution for Google's Hashcode 2017 challenge, submitted during the extended round.
+ *
+ * Function descriptions can be found in scorer.h
+ *
+ **************************************************************************************************/
+
+#include "scorer.h"
+
+Scorer::Scorer(Instance *instance) {
+  this->instance = instance;
+  saved = total_weight = 0;
+
+  // initially each request is served from the datacenter
+  best_latency.resize(instance->get_demands_amount());
+  for (size_t e = 0; e < instance->get_endpoints_amount(); e++) {
+    Span<const size_t> weights = instance->get_demand_weights(e);
+    size_t first = instance->get_first_demand(e);
+    for (size_t i = 0; i < weights.size(); i++) {
+      best_latency[first + i] = instance->get_datacenter_latency(e);
+      total_weight += weights[i];
+    }
+  }
+
+  // account for videos that are already cached, then follow the caches
+  for (size_t c = 0; c < instance->get_caches_amount(); c++) {
+    Span<Request *const> videos = instance->get_cache(c)->get_videos();
+    for (size_t i = 0; i < videos.size(); i++)
+      add(c, videos[i]->get_video_id());
+  }
+  instance->add_listener(this);
+}
+
+Scorer::~Scorer(void) {
+  instance->remove_listener(this);
+}
+
+void Scorer::add(size_t cache, size_t video) {
+  Span<const uint32_t> endpoints = instance->get_cache_endpoints(cache);
+  Span<const uint32_t> latencies = instance->get_cache_latencies(cache);
+  for (size_t i = 0; i < endpoints.size(); i++) {
+    uint32_t d = instance->find_demand(endpoints[i], video);
+    if (d == IdMap::EMPTY)
+      continue;
+
+    // lower the best latency atomically, since caches may notify from several threads
+    uint32_t best = __atomic_load_n(&best_latency[d], __ATOMIC_RELAXED);
+    do {
+      if (latencies[i] >= best)
+        break;
+    } while (!__atomic_compare_exchange_n(&best_latency[d], &best, latencies[i], true,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    if (latencies[i] < best)
+      __atomic_fetch_add(&saved, (uint64_t) instance->get_demand_weight(d) * (best - latencies[i]),
+                         __ATOMIC_RELAXED);
+  }
+}
+
+void Scorer::remove(size_t cache, size_t video) {
+  Span<const uint32_t> endpoints = instance->get_cache_endpoints(cache);
+  Span<const uint32_t> latencies = instance->get_cache_latencies(cache);
+  auto stores = [this](size_t cache, size_t video) {
+    return instance->get_cache(cache)->has_video(video);
+  };
+  for (size_t i = 0; i < endpoints.size(); i++) {
+    uint32_t d = instance->find_demand(endpoints[i], video);
+    if (d == IdMap::EMPTY || latencies[i] != best_latency[d])
+      continue;
+
+    // the endpoint falls back to the fastest other cache storing the video, or the datacenter
+    uint32_t best = instance->find_fallback_latency(endpoints[i], video, stores);
+    saved -= (uint64_t) instance->get_demand_weight(d) * (best - best_latency[d]);
+    best_latency[d] = best;
+  }
+}
+
+uint64_t Scorer::get_score(void) {
+  return total_weight ? get_saved_latency() * 1000 / total_weight : 0;
+}
+
+uint64_t Scorer::get_saved_latency(void) {
+  return __atomic_load_n(&saved, __ATOMIC_RELAXED);
+}
+
+void Scorer::video_added(Cache *cache, Request *video) {
+  add(cache->get_id(), video->get_video_id());
+}
+
+void Scorer::video_removed(Cache *cache, size_t video_id, Span<Endpoint *const> returned) {
+  remove(cache->get_id(), video_id);
+}
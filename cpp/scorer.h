@@ -0,0 +1,90 @@
+/***************************************************************************************************
+ *
+ * scorer.h
+ * @author Ben Witzen
+ * @date Feb 27, 2017
+ *
+ * Part of my solution for Google's Hashcode 2017 challenge, submitted during the extended round.
+ *
+ * Defines the Scorer, which computes the Hashcode score of the videos stored in the caches of an
+ * Instance: the latency saved per request, weighted by the amount of requests, averaged over all
+ * requests, in microseconds (rounded down).
+ *
+ * The Scorer keeps, for every (endpoint, video) request, the lowest latency at which the endpoint
+ * can currently obtain the video. It registers itself with every Cache, and when a video is added
+ * to a cache it only visits the endpoints connected to that cache, so the score stays up to date
+ * without rescanning all requests. Caches may notify the Scorer from several threads at once.
+ * When a video is removed from a cache, the endpoints connected to that cache that got the video
+ * from it look up their next best cache; this must not run concurrently with additions.
+ *
+ **************************************************************************************************/
+
+#ifndef _SCORER_H
+#define _SCORER_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+#include "instance.h"
+#include "youtube.h"
+
+/**
+ * Scorer class.
+ */
+class Scorer : public CacheListener {
+  private:
+    Instance *instance;
+    std::vector<uint32_t> best_latency;
+    uint64_t saved, total_weight;
+
+  public:
+    /**
+     * Constructor. Scores the videos currently stored in the caches of the instance, and keeps
+     * following the caches from then on.
+     * @arg instance The instance to score.
+     */
+    Scorer(Instance *instance);
+
+    /**
+     * Destructor. Stops following the caches of the instance.
+     */
+    ~Scorer(void);
+
+    /**
+     * Accounts for a video that became available in a cache. Adding a video twice has no effect.
+     * @arg cache Cache ID.
+     * @arg video Video ID.
+     */
+    void add(size_t cache, size_t video);
+
+    /**
+     * Accounts for a video that is no longer available in a cache; the cache must not store the
+     * video anymore.
+     * @arg cache Cache ID.
+     * @arg video Video ID.
+     */
+    void remove(size_t cache, size_t video);
+
+    /**
+     * @return The score, as the Hashcode judge computes it.
+     */
+    uint64_t get_score(void);
+
+    /**
+     * @return Sum over all requests of weight * latency saved, in ms.
+     */
+    uint64_t get_saved_latency(void);
+
+    /**
+     * Notification from a cache; see CacheListener.
+     */
+    void video_added(Cache *cache, Request *video);
+
+    /**
+     * Notification from a cache; see CacheListener.
+     */
+    void video_removed(Cache *cache, size_t video_id, Span<Endpoint *const> returned);
+};
+
+#endif // _SCORER_H
@@ -0,0 +1,496 @@
+/***************************************************************************************************
+ *
+ * search.cpp
+ * @author Ben Witzen
+ * @date Feb 27, 2017
+ *
+ * Part of my solution for Google's Hashcode 2017 challenge, submitted during the extended round.
+ *
+ * Implementation of the Search. See search.h for details.
+ *
+ **************************************************************************************************/
+
+#include "search.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+#include "idmap.h"
+
+// the time budget is cut into at least this many epochs, after each of which the best solution is
+// exchanged
+static const size_t EPOCHS = 8;
+
+// moves tried between two looks at the clock
+static const size_t CLOCK_INTERVAL = 256;
+
+// the temperature drops geometrically from its initial value to this fraction of it
+static const double COOLING = 1e-3;
+
+// moves tried to find the initial temperature
+static const size_t SAMPLES = 256;
+
+// a replace move drops at most this many videos to make room
+static const size_t MAX_DROPS = 3;
+
+typedef std::chrono::steady_clock Clock;
+
+// one searcher: its own copy of the cache contents, and the latency every request is served with
+class Searcher {
+  private:
+    // a video added to or dropped from a cache by the move being tried
+    struct Change {
+      uint32_t cache, video;
+      bool added;
+    };
+
+    Instance *instance;
+    // the videos of every cache, and where each video is in the cache's contents
+    std::vector<IdMap> stored;
+    std::vector<std::vector<uint32_t> > contents;
+    std::vector<size_t> remaining;
+    std::vector<uint32_t> best_latency, useful;
+    std::vector<Change> changes;
+    int64_t saved, delta;
+    std::vector<std::vector<uint32_t> > best;
+    int64_t best_saved;
+    bool best_unsaved;
+    std::mt19937_64 random;
+    std::uniform_real_distribution<double> uniform;
+
+    bool has(size_t cache, size_t video) const {
+      return stored[cache].find(video) != IdMap::EMPTY;
+    }
+
+    size_t pick(size_t amount) {
+      return random() % amount;
+    }
+
+    // puts a video into a cache that has room for it; every endpoint of the cache that requests
+    // the video and gets it faster now adds to the delta
+    void add(size_t cache, size_t video, bool record) {
+      stored[cache].insert(video, contents[cache].size());
+      contents[cache].push_back(video);
+      remaining[cache] -= instance->get_video_size(video);
+      Span<const uint32_t> endpoints = instance->get_cache_endpoints(cache);
+      Span<const uint32_t> latencies = instance->get_cache_latencies(cache);
+      for (size_t i = 0; i < endpoints.size(); i++) {
+        uint32_t d = instance->find_demand(endpoints[i], video);
+        if (d == IdMap::EMPTY || latencies[i] >= best_latency[d])
+          continue;
+        delta += (int64_t) instance->get_demand_weight(d) * (best_latency[d] - latencies[i]);
+        best_latency[d] = latencies[i];
+      }
+      if (record) {
+        Change change = {(uint32_t) cache, (uint32_t) video, true};
+        changes.push_back(change);
+      }
+    }
+
+    // takes a video out of a cache; every endpoint that got the video from the cache falls back
+    // to its next best cache, or the datacenter
+    void drop(size_t cache, size_t video, bool record) {
+      std::vector<uint32_t> &videos = contents[cache];
+      uint32_t position = stored[cache].find(video);
+      videos[position] = videos.back();
+      stored[cache].insert(videos[position], position);
+      videos.pop_back();
+      stored[cache].erase(video);
+      remaining[cache] += instance->get_video_size(video);
+      Span<const uint32_t> endpoints = instance->get_cache_endpoints(cache);
+      Span<const uint32_t> latencies = instance->get_cache_latencies(cache);
+      auto stores = [this](size_t cache, size_t video) {
+        return has(cache, video);
+      };
+      for (size_t i = 0; i < endpoints.size(); i++) {
+        uint32_t d = instance->find_demand(endpoints[i], video);
+        if (d == IdMap::EMPTY || latencies[i] != best_latency[d])
+          continue;
+        uint32_t next = instance->find_fallback_latency(endpoints[i], video, stores);
+        delta -= (int64_t) instance->get_demand_weight(d) * (next - best_latency[d]);
+        best_latency[d] = next;
+      }
+      if (record) {
+        Change change = {(uint32_t) cache, (uint32_t) video, false};
+        changes.push_back(change);
+      }
+    }
+
+    // undoes the changes of the move being tried, latest first
+    void undo(void) {
+      for (size_t i = changes.size(); i-- > 0;) {
+        if (changes[i].added)
+          drop(changes[i].cache, changes[i].video, false);
+        else
+          add(changes[i].cache, changes[i].video, false);
+      }
+    }
+
+    // makes the changes of the move being tried again, after undo()
+    void redo(void) {
+      for (size_t i = 0; i < changes.size(); i++) {
+        if (changes[i].added)
+          add(changes[i].cache, changes[i].video, false);
+        else
+          drop(changes[i].cache, changes[i].video, false);
+      }
+    }
+
+    // a video requested by an endpoint of the cache goes in, random videos make room for it
+    bool replace(size_t cache) {
+      Span<const uint32_t> endpoints = instance->get_cache_endpoints(cache);
+      Span<const uint32_t> videos = instance->get_demand_videos(endpoints[pick(endpoints.size())]);
+      if (videos.size() == 0)
+        return false;
+      size_t video = videos[pick(videos.size())], size = instance->get_video_size(video);
+      if (has(cache, video) || size > instance->get_cache_size())
+        return false;
+      for (size_t drops = 0; remaining[cache] < size; drops++) {
+        if (drops == MAX_DROPS)
+          return false;
+        drop(cache, contents[cache][pick(contents[cache].size())], true);
+      }
+      add(cache, video, true);
+      return true;
+    }
+
+    // a video of the cache goes to another cache of one of its endpoints, if it fits there
+    bool move(size_t cache) {
+      if (contents[cache].empty())
+        return false;
+      size_t video = contents[cache][pick(contents[cache].size())];
+      size_t other = neighbour(cache);
+      if (other == cache || has(other, video) ||
+          remaining[other] < instance->get_video_size(video))
+        return false;
+      drop(cache, video, true);
+      add(other, video, true);
+      return true;
+    }
+
+    // a video of the cache and a video of another cache of one of its endpoints trade places
+    bool swap(size_t cache) {
+      size_t other = neighbour(cache);
+      if (other == cache || contents[cache].empty() || contents[other].empty())
+        return false;
+      size_t video = contents[cache][pick(contents[cache].size())];
+      size_t other_video = contents[other][pick(contents[other].size())];
+      if (has(other, video) || has(cache, other_video))
+        return false;
+      drop(cache, video, true);
+      drop(other, other_video, true);
+      if (remaining[cache] < instance->get_video_size(other_video) ||
+          remaining[other] < instance->get_video_size(video))
+        return false;
+      add(cache, other_video, true);
+      add(other, video, true);
+      return true;
+    }
+
+    // a random cache of a random endpoint of the cache
+    size_t neighbour(size_t cache) {
+      Span<const uint32_t> endpoints = instance->get_cache_endpoints(cache);
+      Span<const uint32_t> caches = instance->get_link_caches(endpoints[pick(endpoints.size())]);
+      return caches[pick(caches.size())];
+    }
+
+    // builds a random move and returns true with its changes made, or false with none made
+    bool try_move(void) {
+      changes.clear();
+      delta = 0;
+      size_t cache = useful[pick(useful.size())], kind = pick(3);
+      bool built = kind == 0 ? replace(cache) : kind == 1 ? move(cache) : swap(cache);
+      if (!built)
+        undo();
+      return built;
+    }
+
+  public:
+    size_t moves, accepted;
+
+    Searcher(Instance *instance, uint64_t seed) : instance(instance), random(seed) {
+      size_t caches_amt = instance->get_caches_amount();
+      stored.resize(caches_amt);
+      contents.resize(caches_amt);
+      remaining.resize(caches_amt);
+      best_latency.resize(instance->get_demands_amount());
+      for (size_t c = 0; c < caches_amt; c++)
+        if (instance->get_cache_endpoints(c).size() > 0)
+          useful.push_back(c);
+      moves = accepted = 0;
+    }
+
+    // starts over from a solution
+    void load(const std::vector<std::vector<uint32_t> > &solution) {
+      for (size_t c = 0; c < stored.size(); c++)
+        stored[c].clear();
+      for (size_t e = 0; e < instance->get_endpoints_amount(); e++) {
+        size_t first = instance->get_first_demand(e);
+        for (size_t i = 0; i < instance->get_demand_videos(e).size(); i++)
+          best_latency[first + i] = instance->get_datacenter_latency(e);
+      }
+      delta = 0;
+      for (size_t c = 0; c < contents.size(); c++) {
+        contents[c].clear();
+        remaining[c] = instance->get_cache_size();
+        for (size_t i = 0; i < solution[c].size(); i++)
+          add(c, solution[c][i], false);
+      }
+      saved = best_saved = delta;
+      best = solution;
+      best_unsaved = false;
+    }
+
+    // tries moves until the deadline, at a temperature that drops over the whole budget
+    void run(Clock::time_point start, Clock::time_point deadline, double budget,
+             double temperature) {
+      if (useful.empty())
+        return;
+      for (Clock::time_point now = Clock::now(); now < deadline; now = Clock::now()) {
+        double elapsed = std::chrono::duration<double>(now - start).count();
+        double t = temperature * std::pow(COOLING, elapsed / budget);
+        for (size_t i = 0; i < CLOCK_INTERVAL; i++)
+          step(t);
+      }
+    }
+
+    // tries one move, and keeps it if it pays off or, by chance, if the temperature allows
+    void step(double temperature) {
+      moves++;
+      if (!try_move())
+        return;
+      if (delta < 0 && uniform(random) >= std::exp(delta / temperature)) {
+        undo();
+        return;
+      }
+
+      // the move leaves a best solution behind, which must be copied first
+      accepted++;
+      saved += delta;
+      if (delta < 0 && best_unsaved) {
+        undo();
+        best = contents;
+        best_unsaved = false;
+        redo();
+      }
+      if (saved > best_saved) {
+        best_saved = saved;
+        best_unsaved = true;
+      }
+    }
+
+    // average loss of random moves, as the initial temperature
+    double sample_temperature(void) {
+      double total = 0;
+      size_t amount = 0;
+      for (size_t i = 0; i < SAMPLES && !useful.empty(); i++)
+        if (try_move()) {
+          if (delta != 0) {
+            total += std::abs((double) delta);
+            amount++;
+          }
+          undo();
+        }
+      return amount ? total / amount : 1;
+    }
+
+    const std::vector<std::vector<uint32_t> > &get_best(void) {
+      if (best_unsaved) {
+        best = contents;
+        best_unsaved = false;
+      }
+      return best;
+    }
+
+    int64_t get_best_saved(void) {
+      return best_saved;
+    }
+
+    // true if what this searcher keeps matches a searcher that loaded its contents from scratch:
+    // where every video is, the room left, the latency of every request and the latency saved
+    bool matches(const Searcher &fresh, int64_t expected_saved) const {
+      for (size_t c = 0; c < contents.size(); c++) {
+        if (stored[c].size() != contents[c].size())
+          return false;
+        for (size_t i = 0; i < contents[c].size(); i++)
+          if (stored[c].find(contents[c][i]) != i)
+            return false;
+      }
+      return remaining == fresh.remaining && best_latency == fresh.best_latency &&
+             expected_saved == fresh.saved;
+    }
+
+    // tries random moves the way step() does, keeping some and undoing the others, sometimes
+    // after a redo; after every move and every undo, the searcher must match one loaded from
+    // scratch, and an undo must bring back the contents from before the move. Returns the amount
+    // of moves that failed
+    size_t check(size_t amount) {
+      Searcher fresh(instance, 0);
+      std::vector<std::vector<uint32_t> > before(contents.size()), after(contents.size());
+      auto sorted = [this](std::vector<std::vector<uint32_t> > &to) {
+        for (size_t c = 0; c < contents.size(); c++) {
+          to[c] = contents[c];
+          std::sort(to[c].begin(), to[c].end());
+        }
+      };
+      size_t failures = 0;
+      for (size_t m = 0; m < amount && !useful.empty(); m++) {
+        sorted(before);
+        bool built = try_move();
+        fresh.load(contents);
+        bool ok = matches(fresh, saved + (built ? delta : 0));
+        if (built && pick(4) == 0) {
+          saved += delta;
+          failures += !ok;
+          continue;
+        }
+
+        // a move that could not be built was already undone by try_move()
+        if (built) {
+          undo();
+          if (pick(2) == 0) {
+            redo();
+            undo();
+          }
+        }
+        sorted(after);
+        fresh.load(contents);
+        failures += !(ok && after == before && matches(fresh, saved));
+      }
+      return failures;
+    }
+};
+
+Search::Search(Instance *instance, size_t threads) : instance(instance), pool(threads) {
+  moves = accepted = epochs = 0;
+  listener = NULL;
+  interval = 0;
+  total_weight = 0;
+  for (size_t d = 0; d < instance->get_demands_amount(); d++)
+    total_weight += instance->get_demand_weight(d);
+
+  // the videos stored now are the best solution so far
+  best.resize(instance->get_caches_amount());
+  for (size_t c = 0; c < best.size(); c++) {
+    Span<Request *const> videos = instance->get_cache(c)->get_videos();
+    for (size_t i = 0; i < videos.size(); i++)
+      best[c].push_back(videos[i]->get_video_id());
+  }
+  Searcher searcher(instance, 0);
+  searcher.load(best);
+  start_saved = best_saved = searcher.get_best_saved();
+}
+
+void Search::set_listener(SearchListener *listener, double interval) {
+  this->listener = listener;
+  this->interval = interval;
+}
+
+void Search::run(double seconds, uint64_t seed) {
+  if (seconds <= 0)
+    return;
+
+  // the budget includes setting up the searchers, which each load the solution on their own thread
+  Clock::time_point start = Clock::now();
+  std::vector<Searcher *> searchers(pool.get_threads());
+  pool.parallel_for(searchers.size(), 1, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      searchers[i] = new Searcher(instance, seed + i);
+      searchers[i]->load(best);
+    }
+  });
+  double temperature = searchers[0]->sample_temperature();
+
+  // a listener hears of improvements at the end of an epoch, so it gets one per interval at least
+  size_t epochs_amt = EPOCHS;
+  if (listener && interval > 0)
+    epochs_amt = std::max(epochs_amt, (size_t) std::ceil(seconds / interval));
+
+  // every searcher continues from the best solution of all of them after each epoch
+  for (size_t epoch = 0; epoch < epochs_amt; epoch++) {
+    Clock::time_point deadline = start + std::chrono::duration_cast<Clock::duration>(
+                                             std::chrono::duration<double>(seconds * (epoch + 1) /
+                                                                           epochs_amt));
+    pool.parallel_for(searchers.size(), 1, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++)
+        searchers[i]->run(start, deadline, seconds, temperature);
+    });
+    epochs++;
+
+    Searcher *winner = NULL;
+    for (size_t i = 0; i < searchers.size(); i++)
+      if (searchers[i]->get_best_saved() > (int64_t) best_saved) {
+        winner = searchers[i];
+        best_saved = winner->get_best_saved();
+      }
+    if (winner) {
+      best = winner->get_best();
+      if (listener)
+        listener->improved(best, get_score());
+    }
+    if (epoch + 1 < epochs_amt)
+      pool.parallel_for(searchers.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+          searchers[i]->load(best);
+      });
+  }
+
+  for (size_t i = 0; i < searchers.size(); i++) {
+    moves += searchers[i]->moves;
+    accepted += searchers[i]->accepted;
+    delete searchers[i];
+  }
+}
+
+size_t Search::check(size_t moves, uint64_t seed) {
+  Searcher searcher(instance, seed);
+  searcher.load(best);
+  return searcher.check(moves);
+}
+
+void Search::apply(void) {
+  // removals first, so that the placements find the room they had in the search
+  for (size_t c = 0; c < best.size(); c++) {
+    IdMap keep;
+    for (size_t i = 0; i < best[c].size(); i++)
+      keep.insert(best[c][i], 0);
+    Cache *cache = instance->get_cache(c);
+    std::vector<uint32_t> gone;
+    Span<Request *const> videos = cache->get_videos();
+    for (size_t i = 0; i < videos.size(); i++)
+      if (keep.find(videos[i]->get_video_id()) == IdMap::EMPTY)
+        gone.push_back(videos[i]->get_video_id());
+    for (size_t i = 0; i < gone.size(); i++)
+      cache->remove_video(gone[i]);
+  }
+  for (size_t c = 0; c < best.size(); c++)
+    for (size_t i = 0; i < best[c].size(); i++)
+      if (!instance->get_cache(c)->has_video(best[c][i]))
+        instance->place_video(c, best[c][i]);
+}
+
+uint64_t Search::get_start_score(void) {
+  return total_weight ? start_saved * 1000 / total_weight : 0;
+}
+
+uint64_t Search::get_score(void) {
+  return total_weight ? best_saved * 1000 / total_weight : 0;
+}
+
+size_t Search::get_moves(void) {
+  return moves;
+}
+
+size_t Search::get_accepted(void) {
+  return accepted;
+}
+
+size_t Search::get_epochs(void) {
+  return epochs;
+}
+
+size_t Search::get_threads(void) {
+  return pool.get_threads();
+}
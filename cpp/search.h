@@ -0,0 +1,146 @@
+/***************************************************************************************************
+ *
+ * search.h
+ * @author Ben Witzen
+ * @date Feb 27, 2017
+ *
+ * Part of my solution for Google's Hashcode 2017 challenge, submitted during the extended round.
+ *
+ * Defines the Search, an improvement stage that runs after the computation. Starting from the
+ * videos stored in the caches, it applies random moves to the contents of the caches and keeps
+ * those that pay off, by simulated annealing: a move that loses score is still accepted with a
+ * chance that shrinks as the temperature drops over the time budget.
+ *
+ * Three kinds of moves are tried:
+ *  - replace: put a video requested by an endpoint of a cache into the cache, dropping random
+ *    videos from it until the new one fits (possibly none);
+ *  - move: take a video out of a cache and put it into another cache of an endpoint that
+ *    requests it;
+ *  - swap: exchange a video of a cache with a video of another cache of the same endpoint.
+ * A move is scored by its delta alone: adding a video only visits the endpoints connected to the
+ * cache, and dropping one lets those endpoints that got the video from the cache fall back to
+ * their next best cache, as the Scorer does.
+ *
+ * The search runs one searcher per thread, each with its own copy of the cache contents and its
+ * own seed, over the flat model of the instance, which they share. The time budget is cut into
+ * epochs; after every epoch the best solution any searcher has seen is handed to all of them.
+ * The caches of the instance are only changed by apply(), which makes them store the best
+ * solution found, so that Instance::print_raw() writes it. A SearchListener hears of every better
+ * solution as soon as its epoch ends; epochs are then cut short enough to come at its interval.
+ *
+ **************************************************************************************************/
+
+#ifndef _SEARCH_H
+#define _SEARCH_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+#include "executor.h"
+#include "instance.h"
+
+/**
+ * SearchListener class.
+ */
+class SearchListener {
+  public:
+    /**
+     * Destructor.
+     */
+    virtual ~SearchListener(void) {
+    }
+
+    /**
+     * Called between two epochs, while no searcher runs, when the search found a better solution.
+     * @arg contents IDs of the videos stored by every cache in the better solution.
+     * @arg score Score of the better solution.
+     */
+    virtual void improved(const std::vector<std::vector<uint32_t> > &contents, uint64_t score) {
+    }
+};
+
+/**
+ * Search class.
+ */
+class Search {
+  private:
+    Instance *instance;
+    ThreadPool pool;
+    std::vector<std::vector<uint32_t> > best;
+    uint64_t start_saved, best_saved, total_weight;
+    size_t moves, accepted, epochs;
+    SearchListener *listener;
+    double interval;
+
+  public:
+    /**
+     * Constructor. Takes the videos currently stored in the caches of the instance as the best
+     * solution so far.
+     * @arg instance The instance to improve.
+     * @arg threads Amount of searchers, each on its own thread; 0 means one per core.
+     */
+    Search(Instance *instance, size_t threads);
+
+    /**
+     * Lets a listener hear of every better solution found by run().
+     * @arg listener Reference to the listener.
+     * @arg interval Longest time in seconds between two epochs.
+     */
+    void set_listener(SearchListener *listener, double interval);
+
+    /**
+     * Searches for a better solution.
+     * @arg seconds Wall-clock time budget.
+     * @arg seed Seed of the random generators; searcher i uses seed + i.
+     */
+    void run(double seconds, uint64_t seed);
+
+    /**
+     * Checks the bookkeeping of a searcher, starting from the best solution so far: tries random
+     * moves, keeps some and undoes the others, and compares the score and state the searcher
+     * keeps after each with those of the same contents scored from scratch. Used by check.cpp.
+     * @arg moves Amount of moves to try.
+     * @arg seed Seed of the random generator.
+     * @return Amount of moves after which the two differed.
+     */
+    size_t check(size_t moves, uint64_t seed);
+
+    /**
+     * Makes the caches of the instance store the best solution found: removes the videos it
+     * does not have, then places the ones it adds.
+     */
+    void apply(void);
+
+    /**
+     * @return Score of the solution the search started from.
+     */
+    uint64_t get_start_score(void);
+
+    /**
+     * @return Score of the best solution found.
+     */
+    uint64_t get_score(void);
+
+    /**
+     * @return Amount of moves tried, over all searchers.
+     */
+    size_t get_moves(void);
+
+    /**
+     * @return Amount of moves accepted, over all searchers.
+     */
+    size_t get_accepted(void);
+
+    /**
+     * @return Amount of epochs run; the best solution is exchanged after every one.
+     */
+    size_t get_epochs(void);
+
+    /**
+     * @return Amount of searchers.
+     */
+    size_t get_threads(void);
+};
+
+#endif // _SEARCH_H
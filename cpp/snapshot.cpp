@@ -0,0 +1,158 @@
+/***************************************************************************************************
+ *
+ * snapshot.cpp
+ * @author Ben Witzen
+ * @date Feb 27, 2017
+ *
+ * Part of my solution for Google's Hashcode 2017 challenge, submitted during the extended round.
+ *
+ * Function descriptions can be found in snapshot.h
+ *
+ **************************************************************************************************/
+
+#include "snapshot.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char MAGIC[8] = {'H', 'C', '1', '7', 'S', 'N', 'A', 'P'};
+static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+static const size_t ALIGNMENT = 64;
+
+// hash of a range of bytes, eight at a time; sections are padded, so tails are rare
+static uint64_t checksum(const char *data, size_t length) {
+  uint64_t hash = 0x243f6a8885a308d3ULL;
+  size_t i = 0;
+  for (; i + 8 <= length; i += 8) {
+    uint64_t word;
+    memcpy(&word, data + i, sizeof word);
+    hash = (hash ^ word) * 0x9e3779b97f4a7c15ULL;
+    hash ^= hash >> 29;
+  }
+  for (; i < length; i++)
+    hash = (hash ^ (unsigned char) data[i]) * 0x9e3779b97f4a7c15ULL;
+  return hash;
+}
+
+Snapshot::Snapshot(void) {
+  data = NULL;
+  length = 0;
+}
+
+Snapshot::~Snapshot(void) {
+  if (data)
+    munmap((void *) data, length);
+}
+
+bool Snapshot::is_snapshot(const char *path) {
+  FILE *f = fopen(path, "rb");
+  if (!f)
+    return false;
+  char magic[sizeof MAGIC];
+  bool is = fread(magic, 1, sizeof magic, f) == sizeof magic && memcmp(magic, MAGIC,
+                                                                       sizeof magic) == 0;
+  fclose(f);
+  return is;
+}
+
+bool Snapshot::open(const char *path) {
+  int fd = ::open(path, O_RDONLY);
+  if (fd < 0) {
+    error = std::string(path) + ": cannot open: " + strerror(errno);
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) < 0 || (size_t) st.st_size < sizeof(SnapshotHeader)) {
+    close(fd);
+    error = std::string(path) + ": too small to be a snapshot";
+    return false;
+  }
+  length = st.st_size;
+  void *map = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    length = 0;
+    error = std::string(path) + ": cannot map: " + strerror(errno);
+    return false;
+  }
+  data = (const char *) map;
+
+  // check that the header describes this file; the contents are only checked by verify()
+  const SnapshotHeader *header = get_header();
+  if (memcmp(header->magic, MAGIC, sizeof MAGIC) != 0)
+    error = std::string(path) + ": not a snapshot";
+  else if (header->version != VERSION)
+    error = std::string(path) + ": snapshot has version " + std::to_string(header->version) +
+            ", expected " + std::to_string(VERSION);
+  else if (header->byte_order != BYTE_ORDER_MARK || header->word_size != sizeof(size_t) ||
+           header->header_size != sizeof(SnapshotHeader))
+    error = std::string(path) + ": snapshot was written on another kind of machine";
+  for (size_t s = 0; s < SNAPSHOT_SECTIONS && error.empty(); s++)
+    if (header->sections[s].offset % ALIGNMENT != 0 || header->sections[s].offset > length ||
+        header->sections[s].bytes > length - header->sections[s].offset)
+      error = std::string(path) + ": snapshot is truncated";
+  if (!error.empty())
+    return false;
+
+  madvise(map, length, MADV_WILLNEED);
+  this->path = path;
+  return true;
+}
+
+bool Snapshot::verify(void) {
+  if (checksum(data + sizeof(SnapshotHeader), length - sizeof(SnapshotHeader)) ==
+      get_header()->checksum)
+    return true;
+  error = path + ": snapshot is corrupted (checksum mismatch)";
+  return false;
+}
+
+bool Snapshot::write(const char *path, SnapshotHeader header, const Span<const char> *sections,
+                     std::string *error) {
+  // lay out the sections after the header, and compute the checksum over all of it
+  memcpy(header.magic, MAGIC, sizeof MAGIC);
+  header.version = VERSION;
+  header.byte_order = BYTE_ORDER_MARK;
+  header.word_size = sizeof(size_t);
+  header.header_size = sizeof(SnapshotHeader);
+  std::string body;
+  for (size_t s = 0; s < SNAPSHOT_SECTIONS; s++) {
+    body.resize((sizeof(SnapshotHeader) + body.size() + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT -
+                sizeof(SnapshotHeader), '\0');
+    header.sections[s].offset = sizeof(SnapshotHeader) + body.size();
+    header.sections[s].bytes = sections[s].size();
+    body.append(sections[s].begin(), sections[s].size());
+  }
+  body.resize((sizeof(SnapshotHeader) + body.size() + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT -
+              sizeof(SnapshotHeader), '\0');
+  header.checksum = checksum(body.data(), body.size());
+
+  FILE *f = fopen(path, "wb");
+  if (!f) {
+    *error = std::string(path) + ": cannot open: " + strerror(errno);
+    return false;
+  }
+  bool ok = fwrite(&header, sizeof header, 1, f) == 1 &&
+            fwrite(body.data(), 1, body.size(), f) == body.size();
+  ok &= fclose(f) == 0;
+  if (!ok)
+    *error = std::string(path) + ": cannot write: " + strerror(errno);
+  return ok;
+}
+
+const SnapshotHeader *Snapshot::get_header(void) {
+  return (const SnapshotHeader *) data;
+}
+
+size_t Snapshot::get_size(void) {
+  return length;
+}
+
+const char *Snapshot::get_error(void) {
+  return error.c_str();
+}
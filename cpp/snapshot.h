@@ -0,0 +1,156 @@
+/***************************************************************************************************
+ *
+ * snapshot.h
+ * @author Ben Witzen
+ * @date Feb 27, 2017
+ *
+ * Part of my solution for Google's Hashcode 2017 challenge, submitted during the extended round.
+ *
+ * Defines the Snapshot, a binary file that holds an instance after loading: the flat model of
+ * instance.h, with requests merged and sorted and links sorted. A snapshot is mapped into memory
+ * and its arrays are used where they lie, so loading one skips parsing, merging and sorting.
+ *
+ * A snapshot starts with a SnapshotHeader, followed by the arrays at 64-byte aligned offsets. All
+ * numbers are stored in the byte order and word size of the machine that wrote the file; the
+ * header records both, so a snapshot from another kind of machine is refused rather than misread.
+ * The header carries a format version, and a checksum of everything that follows it. Reading all
+ * of a large snapshot takes longer than the rest of loading it, so opening one leaves the
+ * checksum alone; ./convert --verify checks it.
+ *
+ * Snapshots are written with Instance::save_snapshot(), or by the converter: make convert.
+ *
+ **************************************************************************************************/
+
+#ifndef _SNAPSHOT_H
+#define _SNAPSHOT_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <string>
+
+#include "span.h"
+
+/**
+ * The arrays in a snapshot, in the order in which they are stored.
+ */
+enum SnapshotSection {
+  VIDEO_SIZES,
+  DATACENTER_LATENCY,
+  LINK_OFFSET,
+  LINK_CACHE,
+  LINK_LATENCY,
+  DEMAND_OFFSET,
+  DEMAND_VIDEO,
+  DEMAND_WEIGHT,
+  CACHE_LINK_OFFSET,
+  CACHE_LINK_ENDPOINT,
+  CACHE_LINK_LATENCY,
+  VIDEO_DEMAND_OFFSET,
+  VIDEO_DEMAND_NUMBER,
+  VIDEO_DEMAND_ENDPOINT,
+  VIDEO_DEMAND_LATENCY,
+  VIDEO_DEMAND_WEIGHT,
+  CACHE_DEMAND_OFFSET,
+  CACHE_DEMAND_VIDEO,
+  SNAPSHOT_SECTIONS
+};
+
+/**
+ * The header at the start of a snapshot.
+ */
+struct SnapshotHeader {
+  char magic[8];
+  uint32_t version, byte_order, word_size, header_size;
+  uint64_t videos, endpoints, requests, caches, cache_size;
+  uint64_t checksum;
+  struct {
+    uint64_t offset, bytes;
+  } sections[SNAPSHOT_SECTIONS];
+};
+
+/**
+ * Snapshot class.
+ */
+class Snapshot {
+  private:
+    const char *data;
+    size_t length;
+    std::string path, error;
+
+    // snapshots own their mapping and cannot be copied
+    Snapshot(const Snapshot &);
+    Snapshot &operator=(const Snapshot &);
+
+  public:
+    // format version written into new snapshots; snapshots of other versions are refused
+    static const uint32_t VERSION = 2;
+
+    /**
+     * Constructor.
+     */
+    Snapshot(void);
+
+    /**
+     * Destructor.
+     * Unmaps the snapshot, if one was opened; spans handed out become invalid.
+     */
+    ~Snapshot(void);
+
+    /**
+     * @arg path Path to a file.
+     * @return true if the file starts like a snapshot; it may still be of another version.
+     */
+    static bool is_snapshot(const char *path);
+
+    /**
+     * Maps a snapshot and checks its header and the bounds of its sections.
+     * @arg path Path to the snapshot.
+     * @return true on success, false on failure (see get_error()).
+     */
+    bool open(const char *path);
+
+    /**
+     * Checks the checksum of the opened snapshot, which reads all of it.
+     * @return true if the contents are intact, false otherwise (see get_error()).
+     */
+    bool verify(void);
+
+    /**
+     * Writes a snapshot.
+     * @arg path Path to the file to write.
+     * @arg header Header with all counts filled in; the other fields are filled in here.
+     * @arg sections Contents of every section, indexed by SnapshotSection.
+     * @arg error Gets overwritten with a description of the problem on failure.
+     * @return true on success.
+     */
+    static bool write(const char *path, SnapshotHeader header, const Span<const char> *sections,
+                      std::string *error);
+
+    /**
+     * @return The header of the opened snapshot.
+     */
+    const SnapshotHeader *get_header(void);
+
+    /**
+     * @arg section A section.
+     * @return The contents of the section, as an array of T.
+     */
+    template <typename T>
+    Span<const T> get_section(SnapshotSection section) {
+      const SnapshotHeader *header = get_header();
+      return Span<const T>((const T *) (data + header->sections[section].offset),
+                           header->sections[section].bytes / sizeof(T));
+    }
+
+    /**
+     * @return Size of the snapshot in bytes.
+     */
+    size_t get_size(void);
+
+    /**
+     * @return Description of the last error.
+     */
+    const char *get_error(void);
+};
+
+#endif // _SNAPSHOT_H
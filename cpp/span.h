@@ -0,0 +1,81 @@
+/***************************************************************************************************
+ *
+ * span.h
+ * @author Ben Witzen
+ * @date Feb 27, 2017
+ *
+ * Part of my solution for Google's Hashcode 2017 challenge, submitted during the extended round.
+ *
+ * Defines Span, a non-owning view of a contiguous range of elements. Spans are handed out by
+ * objects that want to expose their internal arrays without copying them; a Span remains valid for
+ * as long as the object that handed it out is alive and does not reallocate the array.
+ *
+ **************************************************************************************************/
+
+#ifndef _SPAN_H
+#define _SPAN_H
+
+#include <cstddef>
+
+/**
+ * Span class.
+ */
+template <typename T>
+class Span {
+  private:
+    T *first;
+    size_t count;
+
+  public:
+    /**
+     * Constructor. Creates an empty span.
+     */
+    Span(void) : first(NULL), count(0) {
+    }
+
+    /**
+     * Constructor.
+     * @arg first Pointer to the first element.
+     * @arg count Amount of elements.
+     */
+    Span(T *first, size_t count) : first(first), count(count) {
+    }
+
+    /**
+     * @return Pointer to the first element.
+     */
+    T *begin(void) const {
+      return first;
+    }
+
+    /**
+     * @return Pointer past the last element.
+     */
+    T *end(void) const {
+      return first + count;
+    }
+
+    /**
+     * @return Amount of elements.
+     */
+    size_t size(void) const {
+      return count;
+    }
+
+    /**
+     * @return true if the span has no elements.
+     */
+    bool empty(void) const {
+      return count == 0;
+    }
+
+    /**
+     * @arg index Position of the element.
+     * @return Reference to the element.
+     */
+    T &operator[](size_t index) const {
+      return first[index];
+    }
+};
+
+#endif // _SPAN_H
@@ -0,0 +1,107 @@
+/***************************************************************************************************
+ *
+ * topology.cpp
+ * @author Ben Witzen
+ * @date Feb 27, 2017
+ *
+ * Part of my solution for Google's Hashcode 2017 challenge, submitted during the extended round.
+ *
+ * Function descriptions can be found in topology.h
+ *
+ **************************************************************************************************/
+
+#include "topology.h"
+
+#include <stdint.h>
+#include <vector>
+
+Topology::Topology(Instance *instance) {
+  uniform_latencies = fully_connected = single_cache = identical_cache_sets = flat_links = true;
+  connected = 0;
+
+  // the caches of the first connected endpoint are marked, and every other one is compared to them
+  std::vector<uint8_t> first_set(instance->get_caches_amount(), 0);
+  size_t first_size = 0;
+  uint32_t datacenter_latency = 0, link_latency = 0;
+  for (size_t e = 0; e < instance->get_endpoints_amount(); e++) {
+    Span<const uint32_t> caches = instance->get_link_caches(e);
+    Span<const uint32_t> latencies = instance->get_link_latencies(e);
+    if (caches.empty())
+      continue;
+
+    if (connected++ == 0) {
+      for (size_t i = 0; i < caches.size(); i++)
+        first_set[caches[i]] = 1;
+      first_size = caches.size();
+      datacenter_latency = instance->get_datacenter_latency(e);
+      link_latency = latencies[0];
+    }
+    else {
+      bool same = caches.size() == first_size;
+      for (size_t i = 0; same && i < caches.size(); i++)
+        same = first_set[caches[i]];
+      identical_cache_sets = identical_cache_sets && same;
+      uniform_latencies = uniform_latencies &&
+                          instance->get_datacenter_latency(e) == datacenter_latency;
+    }
+
+    fully_connected = fully_connected && caches.size() == instance->get_caches_amount();
+    single_cache = single_cache && caches.size() == 1;
+    for (size_t i = 1; i < latencies.size(); i++)
+      flat_links = flat_links && latencies[i] == latencies[0];
+    uniform_latencies = uniform_latencies && latencies[0] == link_latency;
+  }
+  uniform_latencies = uniform_latencies && flat_links;
+}
+
+Shape Topology::get_shape(void) {
+  if (identical_cache_sets && flat_links)
+    return SHAPE_SHARED;
+  if (single_cache)
+    return SHAPE_SEPARATE;
+  return SHAPE_GENERAL;
+}
+
+const char *Topology::get_shape_name(void) {
+  const char *names[] = {"shared", "separate", "general"};
+  return names[get_shape()];
+}
+
+std::string Topology::get_properties(void) {
+  std::string properties;
+  if (uniform_latencies)
+    properties += ", uniform latencies";
+  if (fully_connected)
+    properties += ", fully connected";
+  if (single_cache)
+    properties += ", single-cache";
+  if (identical_cache_sets)
+    properties += ", identical cache sets";
+  if (flat_links)
+    properties += ", flat links";
+  return properties.empty() ? "none" : properties.substr(2);
+}
+
+size_t Topology::get_connected(void) {
+  return connected;
+}
+
+bool Topology::has_uniform_latencies(void) {
+  return uniform_latencies;
+}
+
+bool Topology::is_fully_connected(void) {
+  return fully_connected;
+}
+
+bool Topology::has_single_caches(void) {
+  return single_cache;
+}
+
+bool Topology::has_identical_cache_sets(void) {
+  return identical_cache_sets;
+}
+
+bool Topology::has_flat_links(void) {
+  return flat_links;
+}
@@ -0,0 +1,111 @@
+/***************************************************************************************************
+ *
+ * topology.h
+ * @author Ben Witzen
+ * @date Feb 27, 2017
+ *
+ * Part of my solution for Google's Hashcode 2017 challenge, submitted during the extended round.
+ *
+ * Defines the Topology, which tells whether the links between endpoints and caches have a shape
+ * that makes the problem simpler than it is in general. It looks for these properties:
+ *
+ *   uniform latencies     all endpoints have the same datacenter latency, and all links the same
+ *                         cache latency
+ *   fully connected       every endpoint is connected to every cache
+ *   single-cache          no endpoint is connected to more than one cache
+ *   identical cache sets  all endpoints that are connected to any cache are connected to the
+ *                         same caches
+ *   flat links            the links of each endpoint all have the same latency
+ *
+ * From these follows the shape of the instance, for which a solver can be picked:
+ *
+ *   shared    identical cache sets and flat links (such as trending_today): a video saves the same
+ *             in every cache and a second copy saves nothing, so only which videos go into the
+ *             caches matters, not where. Filling the caches is bin packing.
+ *   separate  single-cache endpoints: no two caches serve the same endpoint, so the videos of one
+ *             cache do not influence the gains of another. Each cache is a knapsack of its own.
+ *   general   anything else.
+ *
+ * Endpoints without any cache cannot be served by a cache, and are left out of all properties.
+ *
+ **************************************************************************************************/
+
+#ifndef _TOPOLOGY_H
+#define _TOPOLOGY_H
+
+#include <cstddef>
+#include <string>
+
+#include "instance.h"
+
+/**
+ * Shapes of an instance, from the most special to the general one.
+ */
+enum Shape {
+  SHAPE_SHARED,
+  SHAPE_SEPARATE,
+  SHAPE_GENERAL
+};
+
+/**
+ * Topology class.
+ */
+class Topology {
+  private:
+    bool uniform_latencies, fully_connected, single_cache, identical_cache_sets, flat_links;
+    size_t connected;
+
+  public:
+    /**
+     * Constructor. Classifies an instance, in time linear in its amount of links.
+     * @arg instance The instance to classify.
+     */
+    Topology(Instance *instance);
+
+    /**
+     * @return The shape of the instance.
+     */
+    Shape get_shape(void);
+
+    /**
+     * @return Name of the shape of the instance: shared, separate or general.
+     */
+    const char *get_shape_name(void);
+
+    /**
+     * @return The properties the instance has, separated by commas, or "none".
+     */
+    std::string get_properties(void);
+
+    /**
+     * @return Amount of endpoints connected to at least one cache.
+     */
+    size_t get_connected(void);
+
+    /**
+     * @return true if all endpoints and all links have the same latency.
+     */
+    bool has_uniform_latencies(void);
+
+    /**
+     * @return true if every endpoint is connected to every cache.
+     */
+    bool is_fully_connected(void);
+
+    /**
+     * @return true if no endpoint is connected to more than one cache.
+     */
+    bool has_single_caches(void);
+
+    /**
+     * @return true if all connected endpoints are connected to the same caches.
+     */
+    bool has_identical_cache_sets(void);
+
+    /**
+     * @return true if the links of each endpoint all have the same latency.
+     */
+    bool has_flat_links(void);
+};
+
+#endif // _TOPOLOGY_H
@@ -0,0 +1,190 @@
+/***************************************************************************************************
+ *
+ * trace.cpp
+ * @author Ben Witzen
+ * @date Feb 27, 2017
+ *
+ * Part of my solution for Google's Hashcode 2017 challenge, submitted during the extended round.
+ *
+ * Implementation of the Trace. See trace.h for details.
+ *
+ * Heap allocations are counted by replacing the global operator new; the array and nothrow forms
+ * of the standard library forward to it.
+ *
+ **************************************************************************************************/
+
+#include "trace.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// counters of one thread, kept in a cache line of their own
+struct alignas(64) CounterSlot {
+  uint64_t counts[TRACE_COUNTERS];
+};
+
+// threads beyond the amount of slots share slots, which costs speed but not correctness
+static const size_t SLOTS = 64;
+static CounterSlot slots[SLOTS];
+static std::atomic<size_t> next_slot(0);
+static thread_local size_t slot = SIZE_MAX;
+
+// names of the counters in the output, indexed by TraceCounter
+static const char *counter_names[TRACE_COUNTERS] = {
+  "push_attempts", "pushes", "merges", "capacity_rejections", "allocations"
+};
+
+#ifdef __linux__
+static const uint64_t hardware_configs[] = {
+  PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES
+};
+#endif
+static const char *hardware_names[] = {"cycles", "instructions", "cache_misses"};
+
+bool Trace::enabled = false;
+
+void *operator new(size_t size) {
+  Trace::count(ALLOCATIONS);
+  void *p = malloc(size ? size : 1);
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void *p) noexcept {
+  free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+  free(p);
+}
+
+void Trace::add(TraceCounter counter) {
+  if (slot == SIZE_MAX)
+    slot = next_slot.fetch_add(1, std::memory_order_relaxed) % SLOTS;
+  __atomic_fetch_add(&slots[slot].counts[counter], 1, __ATOMIC_RELAXED);
+}
+
+Trace::Trace(void) : out(NULL), chrome(false), first_event(true), pass_time(0) {
+  for (size_t i = 0; i < HARDWARE_COUNTERS; i++)
+    perf_fds[i] = -1;
+  memset(pass_counts, 0, sizeof pass_counts);
+  memset(pass_hardware, 0, sizeof pass_hardware);
+  origin = pass_start = std::chrono::steady_clock::now();
+  enabled = true;
+}
+
+Trace::~Trace(void) {
+  enabled = false;
+  if (out) {
+    if (chrome)
+      fprintf(out, "\n]\n");
+    fclose(out);
+  }
+#ifdef __linux__
+  for (size_t i = 0; i < HARDWARE_COUNTERS; i++)
+    if (perf_fds[i] >= 0)
+      close(perf_fds[i]);
+#endif
+}
+
+bool Trace::open(const char *path) {
+  size_t length = strlen(path);
+  chrome = length >= 5 && strcmp(path + length - 5, ".json") == 0;
+  out = fopen(path, "w");
+  if (!out) {
+    error = std::string("cannot open ") + path;
+    return false;
+  }
+  if (chrome)
+    fprintf(out, "[");
+
+#ifdef __linux__
+  // hardware counters are optional; the kernel may not permit them
+  for (size_t i = 0; i < HARDWARE_COUNTERS; i++) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof attr);
+    attr.size = sizeof attr;
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = hardware_configs[i];
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    perf_fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+  }
+#endif
+  return true;
+}
+
+void Trace::read_totals(uint64_t *counts, uint64_t *hardware) {
+  for (size_t c = 0; c < TRACE_COUNTERS; c++) {
+    counts[c] = 0;
+    for (size_t s = 0; s < SLOTS; s++)
+      counts[c] += __atomic_load_n(&slots[s].counts[c], __ATOMIC_RELAXED);
+  }
+  for (size_t i = 0; i < HARDWARE_COUNTERS; i++) {
+    hardware[i] = 0;
+#ifdef __linux__
+    if (perf_fds[i] >= 0 && read(perf_fds[i], &hardware[i], sizeof(uint64_t)) < 0)
+      hardware[i] = 0;
+#endif
+  }
+}
+
+void Trace::begin_pass(void) {
+  read_totals(start_counts, start_hardware);
+  pass_start = std::chrono::steady_clock::now();
+}
+
+void Trace::end_pass(size_t pass, size_t visits) {
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+  uint64_t counts[TRACE_COUNTERS], hardware[HARDWARE_COUNTERS];
+  read_totals(counts, hardware);
+  for (size_t c = 0; c < TRACE_COUNTERS; c++)
+    pass_counts[c] = counts[c] - start_counts[c];
+  for (size_t i = 0; i < HARDWARE_COUNTERS; i++)
+    pass_hardware[i] = hardware[i] - start_hardware[i];
+  pass_time = std::chrono::duration<double, std::milli>(end - pass_start).count();
+  if (out)
+    write_pass(pass, visits,
+               std::chrono::duration<double, std::milli>(pass_start - origin).count());
+}
+
+void Trace::write_pass(size_t pass, size_t visits, double start) {
+  // Chrome traces take microseconds, and show the arguments of each event when it is selected
+  if (chrome) {
+    fprintf(out, "%s\n{\"name\":\"pass %lu\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":%.3f,"
+            "\"dur\":%.3f,\"args\":{\"pass\":%lu,\"visits\":%lu", first_event ? "" : ",", pass,
+            start * 1000, pass_time * 1000, pass, visits);
+    first_event = false;
+  }
+  else
+    fprintf(out, "{\"pass\":%lu,\"start_ms\":%.3f,\"ms\":%.3f,\"visits\":%lu", pass, start,
+            pass_time, visits);
+
+  for (size_t c = 0; c < TRACE_COUNTERS; c++)
+    fprintf(out, ",\"%s\":%lu", counter_names[c], pass_counts[c]);
+  for (size_t i = 0; i < HARDWARE_COUNTERS; i++)
+    if (perf_fds[i] >= 0)
+      fprintf(out, ",\"%s\":%lu", hardware_names[i], pass_hardware[i]);
+  fprintf(out, chrome ? "}}" : "}\n");
+}
+
+uint64_t Trace::get_pass_count(TraceCounter counter) {
+  return pass_counts[counter];
+}
+
+double Trace::get_pass_time(void) {
+  return pass_time;
+}
+
+const char *Trace::get_error(void) {
+  return error.c_str();
+}
@@ -0,0 +1,143 @@
+/***************************************************************************************************
+ *
+ * trace.h
+ * @author Ben Witzen
+ * @date Feb 27, 2017
+ *
+ * Part of my solution for Google's Hashcode 2017 challenge, submitted during the extended round.
+ *
+ * Defines the Trace, which measures every pass of a computation: its wall time, the amount of
+ * pushes attempted, videos added, requests merged, pushes rejected for lack of space and heap
+ * allocations, and, where the kernel permits it, the CPU cycles, instructions and cache misses
+ * of the calling thread. Each pass becomes one record, written either as a line of JSON or as an
+ * event in the Chrome trace format (chrome://tracing, Perfetto).
+ *
+ * Events are counted by calling Trace::count() at the place where they happen. Each thread counts
+ * into its own cache line, and the totals are summed when a pass ends. While no Trace exists,
+ * count() only tests a flag, so leaving the calls in costs next to nothing.
+ *
+ **************************************************************************************************/
+
+#ifndef _TRACE_H
+#define _TRACE_H
+
+#include <chrono>
+#include <cstddef>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+
+/**
+ * Events that are counted while a Trace exists.
+ */
+enum TraceCounter {
+  PUSH_ATTEMPTS,
+  PUSHES,
+  MERGES,
+  CAPACITY_REJECTIONS,
+  ALLOCATIONS,
+  TRACE_COUNTERS
+};
+
+/**
+ * Trace class.
+ */
+class Trace {
+  private:
+    static bool enabled;
+    static const size_t HARDWARE_COUNTERS = 3;
+
+    FILE *out;
+    bool chrome, first_event;
+    int perf_fds[HARDWARE_COUNTERS];
+    std::chrono::steady_clock::time_point origin, pass_start;
+    uint64_t start_counts[TRACE_COUNTERS], pass_counts[TRACE_COUNTERS];
+    uint64_t start_hardware[HARDWARE_COUNTERS], pass_hardware[HARDWARE_COUNTERS];
+    double pass_time;
+    std::string error;
+
+    /**
+     * Adds one to a counter of the calling thread.
+     * @arg counter The counter.
+     */
+    static void add(TraceCounter counter);
+
+    /**
+     * Reads the current totals of all counters.
+     * @arg counts Gets overwritten with the totals of the event counters.
+     * @arg hardware Gets overwritten with the totals of the hardware counters that are open.
+     */
+    void read_totals(uint64_t *counts, uint64_t *hardware);
+
+    /**
+     * Writes the record of the last pass.
+     * @arg pass Pass number.
+     * @arg visits Amount of endpoints visited in the pass.
+     * @arg start Start of the pass, in ms since the Trace was created.
+     */
+    void write_pass(size_t pass, size_t visits, double start);
+
+    // traces own their file and counters and cannot be copied
+    Trace(const Trace &);
+    Trace &operator=(const Trace &);
+
+  public:
+    /**
+     * Constructor. Starts counting events; only one Trace may exist at a time. Nothing is written
+     * until open() is called.
+     */
+    Trace(void);
+
+    /**
+     * Destructor. Completes the output file and stops counting events.
+     */
+    ~Trace(void);
+
+    /**
+     * Starts writing a record for every pass into a file, and opens the hardware counters if the
+     * kernel permits it.
+     * @arg path Path of the file; a path ending in .json gets the Chrome trace format, any other
+     *           path gets one line of JSON per pass.
+     * @return true on success, false on failure (see get_error()).
+     */
+    bool open(const char *path);
+
+    /**
+     * Marks the start of a pass.
+     */
+    void begin_pass(void);
+
+    /**
+     * Marks the end of a pass, and writes its record if a file is open.
+     * @arg pass Pass number.
+     * @arg visits Amount of endpoints visited in the pass.
+     */
+    void end_pass(size_t pass, size_t visits);
+
+    /**
+     * @arg counter The counter.
+     * @return Amount of events counted during the last pass.
+     */
+    uint64_t get_pass_count(TraceCounter counter);
+
+    /**
+     * @return Wall time of the last pass, in ms.
+     */
+    double get_pass_time(void);
+
+    /**
+     * @return Description of the last error.
+     */
+    const char *get_error(void);
+
+    /**
+     * Counts one event, if a Trace exists.
+     * @arg counter The counter.
+     */
+    static void count(TraceCounter counter) {
+      if (__builtin_expect(enabled, false))
+        add(counter);
+    }
+};
+
+#endif // _TRACE_H
@@ -12,12 +12,37 @@
 
 #include "youtube.h"
 
-// Request class
+#include <algorithm>
+#include <atomic>
+
+#include "arena.h"
+#include "trace.h"
+
+// striped locks guarding the video lists of caches, so endpoints can push from several threads
+static const size_t LOCK_STRIPES = 64;
+static std::atomic<bool> cache_locks[LOCK_STRIPES];
+
+// holds the lock of a cache's stripe for as long as it is in scope
+class CacheLock {
+  private:
+    std::atomic<bool> &lock;
+
+  public:
+    CacheLock(size_t id) : lock(cache_locks[id % LOCK_STRIPES]) {
+      while (lock.exchange(true, std::memory_order_acquire))
+        while (lock.load(std::memory_order_relaxed))
+          ;
+    }
+
+    ~CacheLock(void) {
+      lock.store(false, std::memory_order_release);
+    }
+};
 
-size_t Request::instances = 0;
+// Request class
 
-Request::Request(size_t video_id, size_t video_size, size_t weight) {
-  this->id = instances++;
+Request::Request(size_t id, size_t video_id, size_t video_size, size_t weight) {
+  this->id = id;
   this->video_id = video_id;
   this->video_size = video_size;
   this->weight = weight;
@@ -55,36 +80,40 @@ float Request::get_score(void) {
   return weight / (float) video_size;
 }
 
-void Request::merge_with(Request *request) {
+void Request::merge_with(Request *request, RequestPool *pool) {
   // sanity check
   if (video_id != request->get_video_id())
     return;
   
-  // cumulate weight and delete absorbed object
+  // cumulate weight and give back absorbed object
   weight += request->get_weight();
-  delete request;
+  pool->release(request);
 }
 
-// Cache class
+Request *Request::split_off(size_t weight, RequestPool *pool) {
+  this->weight -= weight;
+  return pool->create(video_id, video_size, weight);
+}
 
-size_t Cache::instances = 0;
+// Cache class
 
-Cache::Cache(size_t capacity) {
-  this->id = instances++;
+Cache::Cache(size_t id, size_t capacity, RequestPool *pool) {
+  this->id = id;
   this->capacity = capacity;
-  this->used = 0;
+  this->pool = pool;
+  this->own_remaining = capacity;
+  this->remaining = &own_remaining;
+  this->dropped_sources = 0;
 }
 
 Cache::~Cache(void) {
-  for (size_t i = 0; i < videos.size(); i++)
-    delete videos[i];
   videos.clear();
 }
 
 void Cache::print(void) {
   using namespace std;
   cerr << "CACHE #" << id;
-  cerr << " (usage: " << used << "/" << capacity << " |";
+  cerr << " (usage: " << capacity - get_remaining_space() << "/" << capacity << " |";
   cerr << " videos: " << videos.size() << ")" << endl;
 }
 
@@ -93,31 +122,188 @@ size_t Cache::get_id(void) {
 }
 
 size_t Cache::get_remaining_space(void) {
-  return capacity - used;
+  return __atomic_load_n(remaining, __ATOMIC_RELAXED);
+}
+
+void Cache::bind_remaining_space(size_t *slot) {
+  *slot = *remaining;
+  remaining = slot;
+}
+
+void Cache::add_source(Endpoint *endpoint, size_t video, size_t slot, size_t weight, bool added) {
+  Source source = {endpoint, (uint32_t) video, (uint32_t) slot, last_source.find(video), added,
+                   false, weight};
+  last_source.insert(video, sources.size());
+  sources.push_back(source);
+}
+
+void Cache::drop_source(size_t video) {
+  uint32_t latest = last_source.find(video);
+  if (sources[latest].previous == IdMap::EMPTY)
+    last_source.erase(video);
+  else
+    last_source.insert(video, sources[latest].previous);
+  sources[latest].dropped = true;
+  dropped_sources++;
+}
+
+void Cache::compact_sources(void) {
+  if (dropped_sources < 64 || dropped_sources * 2 < sources.size())
+    return;
+
+  // keep the live sources in order, which keeps every chain in order too
+  size_t n = 0;
+  last_source.clear();
+  for (size_t i = 0; i < sources.size(); i++)
+    if (!sources[i].dropped) {
+      sources[n] = sources[i];
+      sources[n].previous = last_source.find(sources[n].video);
+      last_source.insert(sources[n].video, n);
+      n++;
+    }
+  sources.resize(n);
+  dropped_sources = 0;
 }
 
 bool Cache::push_video(Endpoint *endpoint, Request *video) {
-  // merge new video with old object, if it already occurs in this Cache
-  for (size_t i = 0; i < videos.size(); i++) {
-    if (video->get_video_id() == videos[i]->get_video_id()) {
-      endpoint->pull_request_by_id(video->get_video_id());
-      videos[i]->merge_with(video);
-      return true;
+  size_t video_id = video->get_video_id(), size = video->get_video_size();
+  Request *stored;
+  bool merged;
+  Trace::count(PUSH_ATTEMPTS);
+
+  {
+    CacheLock lock(id);
+
+    // merge new video with old object, if it already occurs in this Cache
+    uint32_t position = positions.find(video_id);
+    merged = position != IdMap::EMPTY;
+    if (merged) {
+      stored = videos[position];
+      uint32_t slot = endpoint != NULL ? endpoint->find_slot(video_id) : IdMap::EMPTY;
+      add_source(slot != IdMap::EMPTY ? endpoint : NULL, video_id, slot, video->get_weight(),
+                 false);
+      if (slot != IdMap::EMPTY)
+        endpoint->pull_request_by_id(video_id);
+      stored->merge_with(video, pool);
+      Trace::count(MERGES);
+    }
+
+    // otherwise reserve space for this video, if the remaining capacity allows for it; the lock
+    // keeps other writers out, the atomic store keeps readers of the remaining space exact
+    else {
+      size_t space = __atomic_load_n(remaining, __ATOMIC_RELAXED);
+      if (size > space) {
+        Trace::count(CAPACITY_REJECTIONS);
+        return false;
+      }
+      __atomic_store_n(remaining, space - size, __ATOMIC_RELAXED);
+
+      // move video from endpoint to cache
+      stored = video;
+      positions.insert(video_id, videos.size());
+      videos.push_back(video);
+      uint32_t slot = endpoint != NULL ? endpoint->find_slot(video_id) : IdMap::EMPTY;
+      add_source(slot != IdMap::EMPTY ? endpoint : NULL, video_id, slot, video->get_weight(),
+                 true);
+      if (slot != IdMap::EMPTY)
+        endpoint->pull_request_by_id(video_id);
+      Trace::count(PUSHES);
     }
   }
-  
-  // check if remaining capacity allows for adding this video  
-  if (used + video->get_video_size() > capacity)
-    return false;
-  
-  // move video from endpoint to cache
-  used += video->get_video_size();
-  videos.push_back(video);
-  endpoint->pull_request_by_id(video->get_video_id());
 
+  for (size_t i = 0; i < listeners.size(); i++) {
+    if (merged)
+      listeners[i]->video_merged(this, stored);
+    else
+      listeners[i]->video_added(this, stored);
+  }
   return true;
 }
 
+bool Cache::remove_video(size_t video_id) {
+  std::vector<Endpoint *> returned;
+
+  {
+    CacheLock lock(id);
+
+    // take the video out, keeping the order of the others
+    uint32_t position = positions.find(video_id);
+    if (position == IdMap::EMPTY)
+      return false;
+    Request *stored = videos[position];
+    size_t size = stored->get_video_size();
+    videos.erase(videos.begin() + position);
+    positions.erase(video_id);
+    for (size_t i = position; i < videos.size(); i++)
+      positions.insert(videos[i]->get_video_id(), i);
+
+    // hand merged requests back from the latest to the first, then the stored one itself
+    for (uint32_t s = last_source.find(video_id); s != IdMap::EMPTY; s = sources[s].previous) {
+      Request *request = sources[s].added ? stored : stored->split_off(sources[s].weight, pool);
+      if (sources[s].endpoint != NULL)
+        sources[s].endpoint->restore_request(sources[s].slot, request);
+      else
+        pool->release(request);
+      returned.push_back(sources[s].endpoint);
+    }
+    while (last_source.find(video_id) != IdMap::EMPTY)
+      drop_source(video_id);
+    std::reverse(returned.begin(), returned.end());
+    compact_sources();
+
+    __atomic_store_n(remaining, __atomic_load_n(remaining, __ATOMIC_RELAXED) + size,
+                     __ATOMIC_RELAXED);
+  }
+
+  Span<Endpoint *const> span(returned.data(), returned.size());
+  for (size_t i = 0; i < listeners.size(); i++)
+    listeners[i]->video_removed(this, video_id, span);
+  return true;
+}
+
+bool Cache::return_request(size_t video_id) {
+  Endpoint *endpoint;
+
+  {
+    CacheLock lock(id);
+    uint32_t latest = last_source.find(video_id);
+    if (latest == IdMap::EMPTY || sources[latest].added)
+      return false;
+    endpoint = sources[latest].endpoint;
+    Request *request = videos[positions.find(video_id)]->split_off(sources[latest].weight, pool);
+    if (endpoint != NULL)
+      endpoint->restore_request(sources[latest].slot, request);
+    else
+      pool->release(request);
+    drop_source(video_id);
+    compact_sources();
+  }
+
+  for (size_t i = 0; i < listeners.size(); i++)
+    listeners[i]->request_returned(this, endpoint, video_id);
+  return true;
+}
+
+Span<Request *const> Cache::get_videos(void) {
+  return Span<Request *const>(videos.data(), videos.size());
+}
+
+bool Cache::has_video(size_t video_id) {
+  return positions.find(video_id) != IdMap::EMPTY;
+}
+
+void Cache::add_listener(CacheListener *listener) {
+  listeners.push_back(listener);
+}
+
+void Cache::remove_listener(CacheListener *listener) {
+  for (size_t i = 0; i < listeners.size(); i++)
+    if (listeners[i] == listener) {
+      listeners.erase(listeners.begin() + i);
+      return;
+    }
+}
+
 void Cache::print_raw(FILE *f) {
   using namespace std;
   fprintf(f, "%lu", id);
@@ -128,16 +314,15 @@ void Cache::print_raw(FILE *f) {
 
 // Endpoint class
 
-size_t Endpoint::instances = 0;
-
-Endpoint::Endpoint(size_t latency) {
-  this->id = instances++;
+Endpoint::Endpoint(size_t id, size_t latency, RequestPool *pool) {
+  this->id = id;
   this->datacenter_latency = latency;
+  this->pool = pool;
+  this->head = 0;
+  this->live = 0;
 }
 
 Endpoint::~Endpoint(void) {
-  for (size_t i = 0; i < requests.size(); i++)
-    delete requests[i];
   caches.clear();
   caches_latency.clear();
 }
@@ -147,7 +332,7 @@ void Endpoint::print(void) {
   cerr << "ENDPOINT #" << id;
   cerr << " (latency: " << datacenter_latency;
   cerr << " caches: " << caches.size() << " |";
-  cerr << " requests: " << requests.size() << ")" << endl;
+  cerr << " requests: " << live << ")" << endl;
 }
 
 size_t Endpoint::get_id(void) {
@@ -158,26 +343,54 @@ size_t Endpoint::get_datacenter_latency(void) {
   return datacenter_latency;
 }
 
-Request *Endpoint::pull_request_by_index(size_t index) {
-  if (index >= requests.size())
-    return NULL;
-  Request *tmp = requests[index];
-  requests.erase(requests.begin() + index);
-  return tmp;
+void Endpoint::clear_slot(size_t slot) {
+  slots.erase(requests[slot]->get_video_id());
+  requests[slot] = NULL;
+  live--;
+  while (head < requests.size() && requests[head] == NULL)
+    head++;
 }
 
-Request *Endpoint::pull_request_by_id(size_t id) {
-  for (size_t i = 0; i < requests.size(); i++)
-    if (requests[i]->get_video_id() == id) {
+Request *Endpoint::pull_request_by_index(size_t index) {
+  if (index >= live)
+    return NULL;
+  for (size_t i = head; i < requests.size(); i++)
+    if (requests[i] != NULL && index-- == 0) {
       Request *tmp = requests[i];
-      requests.erase(requests.begin() + i);
+      clear_slot(i);
       return tmp;
     }
   return NULL;
 }
 
+Request *Endpoint::pull_request_by_id(size_t id) {
+  uint32_t slot = slots.find(id);
+  if (slot == IdMap::EMPTY)
+    return NULL;
+  Request *tmp = requests[slot];
+  clear_slot(slot);
+  return tmp;
+}
+
+Request *Endpoint::find_request(size_t id) {
+  uint32_t slot = slots.find(id);
+  return slot == IdMap::EMPTY ? NULL : requests[slot];
+}
+
+uint32_t Endpoint::find_slot(size_t id) {
+  return slots.find(id);
+}
+
+void Endpoint::restore_request(size_t slot, Request *request) {
+  requests[slot] = request;
+  slots.insert(request->get_video_id(), slot);
+  live++;
+  if (slot < head)
+    head = slot;
+}
+
 size_t Endpoint::get_stored_requests(Request ***requests) {
-  size_t requests_count = this->requests.size();
+  size_t requests_count = live;
   
   // check if there are any requests
   if (requests_count == 0) {
@@ -185,10 +398,11 @@ size_t Endpoint::get_stored_requests(Request ***requests) {
     return 0;
   }
 
-  // copy over all pointers from vector
+  // copy over all pointers from vector, skipping empty slots
   Request **list = new Request *[requests_count];
-  for (size_t i = 0; i < requests_count; i++)
-    list[i] = this->requests[i];
+  for (size_t i = head, n = 0; n < requests_count; i++)
+    if (this->requests[i] != NULL)
+      list[n++] = this->requests[i];
   
   *requests = list;
   return requests_count;
@@ -230,6 +444,26 @@ size_t Endpoint::get_caches_latencies(size_t **latencies) {
   return caches_count;
 }
 
+Span<Cache *const> Endpoint::get_caches(void) {
+  return Span<Cache *const>(caches.data(), caches.size());
+}
+
+Span<const size_t> Endpoint::get_latencies(void) {
+  return Span<const size_t>(caches_latency.data(), caches_latency.size());
+}
+
+Span<Request *const> Endpoint::get_requests(void) {
+  return Span<Request *const>(requests.data() + head, requests.size() - head);
+}
+
+Request *Endpoint::get_top_request(void) {
+  return head < requests.size() ? requests[head] : NULL;
+}
+
+size_t Endpoint::get_requests_amount(void) {
+  return live;
+}
+
 void Endpoint::add_cache(Cache *ref, size_t latency) {
   if (caches.empty()) {
     caches.push_back(ref);
@@ -248,7 +482,19 @@ void Endpoint::add_cache(Cache *ref, size_t latency) {
 }
 
 void Endpoint::add_request(Request *request) {
+  // slots are compacted first, so the merging and sorting below see no empty slots
+  if (live < requests.size()) {
+    size_t n = 0;
+    for (size_t i = 0; i < requests.size(); i++)
+      if (requests[i] != NULL)
+        requests[n++] = requests[i];
+    requests.resize(n);
+    head = 0;
+  }
+  live++;
+
   if (requests.empty()) {
+    slots.insert(request->get_video_id(), 0);
     requests.push_back(request);
     return;
   }
@@ -257,8 +503,9 @@ void Endpoint::add_request(Request *request) {
   // if so, purge the old stored request and offer the merged request for sorting
   for (size_t i = 0; i < requests.size(); i++) {
     if (requests[i]->get_video_id() == request->get_video_id()) {
-      request->merge_with(requests[i]);
+      request->merge_with(requests[i], pool);
       requests.erase(requests.begin() + i);
+      live--;
       break;
     }
   }
@@ -270,5 +517,27 @@ void Endpoint::add_request(Request *request) {
       break;
   
   requests.insert(requests.begin() + slot, request);
+
+  // slots after the insertion point have moved
+  slots.clear();
+  for (size_t i = 0; i < requests.size(); i++)
+    slots.insert(requests[i]->get_video_id(), i);
 }
 
+void Endpoint::reserve(size_t caches_amount, size_t requests_amount) {
+  caches.reserve(caches.size() + caches_amount);
+  caches_latency.reserve(caches_latency.size() + caches_amount);
+  requests.reserve(requests.size() + requests_amount);
+  slots.reserve(slots.size() + requests_amount);
+}
+
+void Endpoint::append_cache(Cache *ref, size_t latency) {
+  caches.push_back(ref);
+  caches_latency.push_back(latency);
+}
+
+void Endpoint::append_request(Request *request) {
+  slots.insert(request->get_video_id(), requests.size());
+  requests.push_back(request);
+  live++;
+}
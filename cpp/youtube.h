@@ -13,7 +13,9 @@
  * are used interchangeably. This is due to the fact that Requests can be pushed into Caches, from
  * which point they start acting as a stored video on that Cache rather than a request.
  *
- * `Cache`: Caches offer an interface that allows for adding and removing videos.
+ * `Cache`: Caches offer an interface that allows for adding and removing videos. A Cache remembers
+ * which endpoint each of its stored requests came from, and with what weight, so that removing a
+ * video hands every request back to the endpoint slot it was pulled from.
  *
  * `Endpoint`: Endpoints consist of a queue of video requests and are connected to zero or more
  * Cache objects. They form the "heart" of a computation; this is the object that is directly inter-
@@ -21,6 +23,28 @@
  * Note that if multiple Endpoints share a Cache, each of those Endpoints actually points to the
  * exact same Cache object in memory.
  *
+ * Endpoints hand out their caches, latencies and requests as Spans over their internal storage,
+ * so a compute() function can inspect them without allocating anything. Pulling a request leaves
+ * an empty (NULL) slot behind rather than shifting the remaining requests, so a Span of
+ * requests stays valid while videos are pushed from it, and a request that is handed back
+ * returns to its old position.
+ *
+ * `CacheListener`: Objects that need to follow the contents of Caches (such as the Scorer)
+ * implement this interface and register with each Cache they follow.
+ *
+ * Request objects are created by the RequestPool of the Instance (see arena.h), which also takes
+ * back the requests that are merged away and frees all of them at once. Caches and Endpoints hand
+ * requests to the pool rather than deleting them, and do not destroy the requests they hold.
+ *
+ * Both Caches and Endpoints index their videos by video ID, so checking whether a Cache already
+ * stores a video and pulling a request from an Endpoint take constant time.
+ *
+ * Different Endpoints may push videos into the same Cache from different threads: a Cache guards
+ * its video list and its remaining capacity with a (striped) lock, and updates the capacity with
+ * atomic stores, so that it can be read without the lock.
+ * An Endpoint itself must only be used by one thread at a time. Removing videos and returning
+ * requests must not run concurrently with pushes to caches of the same endpoints.
+ *
  **************************************************************************************************/
 
 #ifndef _YOUTUBE_H
@@ -28,30 +52,36 @@
 
 #include <cstddef>
 #include <iostream>
+#include <stdint.h>
 #include <vector>
 #include <stdio.h>
 
+#include "idmap.h"
+#include "span.h"
+
 // forward declarations
 class Request;
 class Cache;
 class Endpoint;
+class CacheListener;
+class RequestPool;
 
 /**
  * Request class.
  */
 class Request {
   private:
-    static size_t instances;
     size_t id, video_id, video_size, weight;
 
   public:
     /**
-     * Constructor.
+     * Constructor. Requests are created by a RequestPool (see arena.h).
+     * @arg id Object ID, numbered by the pool.
      * @arg video_id Video ID of the request.
      * @arg video_size Size of the video being requested.
      * @arg weight Weight of the request.
      */
-    Request(size_t video_id, size_t video_size, size_t weight);
+    Request(size_t id, size_t video_id, size_t video_size, size_t weight);
     
     /**
      * Destructor.
@@ -90,11 +120,21 @@ class Request {
 
     /**
      * Merge another video request with this one. Requires both objects to carry the same value for
-     * the video_id field. The weight of both requests is added together. Once merged, it's not
-     * possible to split the object to obtain the original objects.
-     * @arg request The request to merge with, which is then deleted from memory.
+     * the video_id field. The weight of both requests is added together. The original objects can
+     * only be recovered with split_off() by someone who remembers their weights.
+     * @arg request The request to merge with, which is then given back to the pool.
+     * @arg pool The pool that created both requests.
      */
-    void merge_with(Request *request);
+    void merge_with(Request *request, RequestPool *pool);
+
+    /**
+     * Undoes a merge: moves part of the weight of this request into a new request for the same
+     * video.
+     * @arg weight Weight to move, at most the weight of this request.
+     * @arg pool The pool to create the new request with.
+     * @return The new request.
+     */
+    Request *split_off(size_t weight, RequestPool *pool);
 };
 
 /**
@@ -102,20 +142,58 @@ class Request {
  */
 class Cache {
   private:
-    static size_t instances;
-    size_t id, capacity, used;
+    // a request pushed into this cache, and the endpoint it came from (NULL if none); requests
+    // for the same video are chained from the latest to the first through `previous`
+    struct Source {
+      Endpoint *endpoint;
+      uint32_t video, slot, previous;
+      bool added, dropped;
+      size_t weight;
+    };
+
+    size_t id, capacity, own_remaining;
+    size_t *remaining;
+    RequestPool *pool;
     std::vector<Request *> videos;
+    IdMap positions;
+    std::vector<Source> sources;
+    IdMap last_source;
+    size_t dropped_sources;
+    std::vector<CacheListener *> listeners;
+
+    /**
+     * Remembers where a request that was pushed into this cache came from.
+     * @arg endpoint The endpoint the request was pulled from, or NULL.
+     * @arg video Video ID.
+     * @arg slot Position the request had in the endpoint, if any.
+     * @arg weight Weight of the request.
+     * @arg added true if the request became the stored video, false if it was merged into it.
+     */
+    void add_source(Endpoint *endpoint, size_t video, size_t slot, size_t weight, bool added);
+
+    /**
+     * Forgets the latest source of a video.
+     * @arg video Video ID.
+     */
+    void drop_source(size_t video);
+
+    /**
+     * Rebuilds the list of sources without the dropped ones, once they make up most of it.
+     */
+    void compact_sources(void);
   
   public:
     /**
      * Constructor.
+     * @arg id Cache ID, as numbered in the input file.
      * @arg capacity Maximum amount of MB this cache can store.
+     * @arg pool The pool of the requests pushed into this cache.
      */
-    Cache(size_t capacity);
+    Cache(size_t id, size_t capacity, RequestPool *pool);
     
     /**
      * Destructor.
-     * Any Request objects stored within this Cache are also destroyed.
+     * Any Request objects stored within this Cache are left to their pool.
      */
     ~Cache(void);
 
@@ -133,17 +211,67 @@ class Cache {
      * @return Leftover capacity of this cache in MB.
      */
     size_t get_remaining_space(void);
+
+    /**
+     * Moves the leftover capacity counter of this cache into external storage, so that the owner
+     * of many caches can keep all of their counters in one contiguous array.
+     * @arg slot Storage for the counter; its current value is overwritten.
+     */
+    void bind_remaining_space(size_t *slot);
     
     /**
      * Attempts moving a video from *endpoint to this Cache. Fails if this Cache doesn't have enough
      * space to accept the new video. On success, the *request object may become deallocated from
      * memory.
-     * @arg endpoint The endpoint owning request.
+     * @arg endpoint The endpoint owning request, or NULL if the request is not lined up in any
+     *              endpoint.
      * @arg request The video data to push to this cache.
      * @return true on success, false on failure.
      */
     bool push_video(Endpoint *endpoint, Request *request);
 
+    /**
+     * Removes a video from this Cache and frees its space. Every request that was pushed into the
+     * video is handed back to the endpoint it came from, at its old position and with its own
+     * weight; requests that were pushed without an endpoint are given back to the pool.
+     * @arg video_id Video ID.
+     * @return true on success, false if this cache does not store the video.
+     */
+    bool remove_video(size_t video_id);
+
+    /**
+     * Undoes the latest merge into a stored video: the merged request is handed back to the
+     * endpoint it came from, at its old position and with its own weight, or given back to the
+     * pool if it was pushed without an endpoint. The video stays in this Cache.
+     * @arg video_id Video ID.
+     * @return true on success, false if no request was merged into the video after it was added.
+     */
+    bool return_request(size_t video_id);
+
+    /**
+     * @return All videos stored in this cache, in the order they were added. The span remains
+     *         valid until the next video is added.
+     */
+    Span<Request *const> get_videos(void);
+
+    /**
+     * @arg video_id Video ID.
+     * @return true if this cache stores the video.
+     */
+    bool has_video(size_t video_id);
+
+    /**
+     * Registers a listener that is notified of every change to the contents of this cache.
+     * @arg listener Reference to the listener; it must outlive this cache or be removed first.
+     */
+    void add_listener(CacheListener *listener);
+
+    /**
+     * Unregisters a listener that was registered with add_listener().
+     * @arg listener Reference to the listener.
+     */
+    void remove_listener(CacheListener *listener);
+
     /**
      * Prints to stdout a representation of the object. This follows the submission format as was
      * provided by Google, and as such is not very human readable.
@@ -158,22 +286,32 @@ class Cache {
 
 class Endpoint {
   private:
-    static size_t instances;
     size_t id, datacenter_latency;
+    RequestPool *pool;
     std::vector<Cache *> caches;
     std::vector<size_t> caches_latency;
     std::vector<Request *> requests;
+    IdMap slots;
+    size_t head, live;
+
+    /**
+     * Empties a request slot and moves `head` past any leading empty slots.
+     * @arg slot Position of the request to remove.
+     */
+    void clear_slot(size_t slot);
   
   public:
     /**
      * Constructor.
+     * @arg id Endpoint ID, as numbered in the input file.
      * @arg latency Latency in ms to datacenter.
+     * @arg pool The pool of the requests of this endpoint.
      */
-    Endpoint(size_t latency);
+    Endpoint(size_t id, size_t latency, RequestPool *pool);
     
     /**
      * Destructor.
-     * Any Request objects stored within this Endpoint are also destroyed.
+     * Any Request objects stored within this Endpoint are left to their pool.
      * Any Cache objects referenced by this Endpoint are left untouched.
      */
     ~Endpoint(void);
@@ -207,6 +345,29 @@ class Endpoint {
      */
     Request *pull_request_by_id(size_t id);
 
+    /**
+     * Finds a request without removing it from the endpoint.
+     * @arg id Identifier of the request.
+     * @return Reference to the request, or NULL if the endpoint has no such request lined up.
+     */
+    Request *find_request(size_t id);
+
+    /**
+     * @arg id Identifier of a request.
+     * @return Position of the request among the slots of get_requests(), counted from the first
+     *         slot ever rather than from the current head, or IdMap::EMPTY if the endpoint has no
+     *         such request lined up.
+     */
+    uint32_t find_slot(size_t id);
+
+    /**
+     * Lines a request up again at the position it was pulled from.
+     * @arg slot Position, as returned by find_slot() before the request was pulled; the slot must
+     *           be empty.
+     * @arg request Reference to the request object.
+     */
+    void restore_request(size_t slot, Request *request);
+
     /**
      * Gets an array of pointers to all video requests lined up in this endpoint. The requests are
      * stored by their score; from highest score to lowest score.
@@ -234,6 +395,36 @@ class Endpoint {
      */
     size_t get_caches_latencies(size_t **latencies);
 
+    /**
+     * @return All caches connected to this endpoint, from fastest to slowest cache. The span
+     *         remains valid for the lifetime of the endpoint.
+     */
+    Span<Cache *const> get_caches(void);
+
+    /**
+     * @return Latencies to the caches, in the order of get_caches(). The span remains valid for
+     *         the lifetime of the endpoint.
+     */
+    Span<const size_t> get_latencies(void);
+
+    /**
+     * Gets the request slots of this endpoint, from highest score to lowest score. A slot is NULL
+     * once its request has been pulled from the endpoint; slots never move, so the span remains
+     * valid while requests are pulled (for instance by Cache::push_video()).
+     * @return Span of request slots.
+     */
+    Span<Request *const> get_requests(void);
+
+    /**
+     * @return The highest scoring request still lined up in this endpoint, or NULL if none.
+     */
+    Request *get_top_request(void);
+
+    /**
+     * @return Amount of requests still lined up in this endpoint.
+     */
+    size_t get_requests_amount(void);
+
     /**
      * (Used during initialization only.) Pushes a cache reference to this endpoint, implying this
      * endpoint has a connection to said cache.
@@ -245,11 +436,85 @@ class Endpoint {
     /**
      * (Used during initialization only.) Pushes a request reference to this endpoint. Note that the
      * datasets provided apparently have multiple seperate lines for video requests that request the
-     * same video from the same endpoint. This function will fuse and purge the excess objects
-     * accordingly.
+     * same video from the same endpoint. This function will fuse the requests and give the excess
+     * objects back to the pool accordingly.
      * @arg video Reference to the request object.
      */
     void add_request(Request *request);
+
+    /**
+     * (Used during initialization only.) Makes room for more caches and requests, so that adding
+     * them does not allocate memory one by one.
+     * @arg caches_amount Amount of caches that will be added.
+     * @arg requests_amount Amount of requests that will be appended.
+     */
+    void reserve(size_t caches_amount, size_t requests_amount);
+
+    /**
+     * (Used during initialization only.) Appends a cache reference to this endpoint, without
+     * looking for its place. The caller is responsible for appending the caches in the order
+     * add_cache() would have produced.
+     * @arg ref Reference to cache object.
+     * @arg latency Latency in ms to this cache.
+     */
+    void append_cache(Cache *ref, size_t latency);
+
+    /**
+     * (Used during initialization only.) Appends a request reference to this endpoint, without
+     * merging or sorting. The caller is responsible for appending each video at most once, in the
+     * order add_request() would have produced.
+     * @arg request Reference to the request object.
+     */
+    void append_request(Request *request);
+};
+
+/**
+ * CacheListener class.
+ */
+class CacheListener {
+  public:
+    /**
+     * Destructor.
+     */
+    virtual ~CacheListener(void) {
+    }
+
+    /**
+     * Called after a video was added to a cache that did not store it yet. May be called from
+     * several threads at once, for different caches.
+     * @arg cache The cache the video was added to.
+     * @arg video The stored video.
+     */
+    virtual void video_added(Cache *cache, Request *video) {
+    }
+
+    /**
+     * Called after a request was merged into a video that a cache already stores.
+     * @arg cache The cache storing the video.
+     * @arg video The stored video, which now includes the weight of the merged request.
+     */
+    virtual void video_merged(Cache *cache, Request *video) {
+    }
+
+    /**
+     * Called after a video was removed from a cache.
+     * @arg cache The cache the video was removed from.
+     * @arg video_id Video ID.
+     * @arg returned The endpoints that got their requests back, in the order the requests were
+     *               pushed, with NULL for requests pushed without an endpoint; the first one added
+     *               the video.
+     */
+    virtual void video_removed(Cache *cache, size_t video_id, Span<Endpoint *const> returned) {
+    }
+
+    /**
+     * Called after Cache::return_request() undid a merge.
+     * @arg cache The cache storing the video.
+     * @arg endpoint The endpoint that got its request back, or NULL if the request was deleted.
+     * @arg video_id Video ID.
+     */
+    virtual void request_returned(Cache *cache, Endpoint *endpoint, size_t video_id) {
+    }
 };
 
 #endif // _YOUTUBE_H